@@ -0,0 +1,191 @@
+// Benchmarks against the in-process test server, so they need neither a browser
+// nor the network. `make run-bench` runs them all; `./bench <name>...` some.
+// Timings depend on the machine: compare the rows of one run, not runs.
+#include "curling.hpp"
+#include "test_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void report(const std::string& what, double millis) {
+    std::printf("  %-60s %10.1f ms\n", what.c_str(), millis);
+}
+
+// Average time of one POST of body, with the given transport profile
+double timePost(TestServer& server, const std::string& body, const curling::TransportProfile& profile, int rounds) {
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        curling::Request request;
+        request.setURL(server.url()).setMethod(curling::Request::Method::POST)
+               .setTransportProfile(profile).setBody(body).send();
+    }
+    return millisSince(start) / rounds;
+}
+
+// Large request bodies: libcurl's Expect: 100-continue against the lowLatency profile
+void expectContinue() {
+    TestServer server(TestServer::text("ok"));
+    const std::string body(2 * 1024 * 1024, 'x');
+    report("2 MB POST, Expect answered by the server", timePost(server, body, curling::TransportProfile(), 20));
+    report("2 MB POST, lowLatency profile (no Expect)", timePost(server, body, curling::TransportProfile::lowLatency(), 20));
+    server.setAnswerContinue(false);
+    report("2 MB POST, Expect ignored by the server", timePost(server, body, curling::TransportProfile(), 3));
+}
+
+// Ranged downloads on several connections, from a server that paces each connection
+void parallelDownload() {
+    const std::string content = testContent(200 * 1024 * 1024);
+    TestServer server([&content](const TestRequest& request) {
+        TestReply reply = serveFile(request, content, "\"v1\"");
+        reply.bytesPerSecond = 50 * 1024 * 1024;
+        return reply;
+    });
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_bench.bin").string();
+    for (unsigned connections : {1u, 4u, 8u}) {
+        curling::ParallelDownloadOptions options;
+        options.connections = connections;
+        auto start = Clock::now();
+        curling::downloadParallel(server.url("/file"), path, options);
+        double millis = millisSince(start);
+        bool intact = readFile(path) == content;
+        report("200 MB at 50 MB/s per connection, " + std::to_string(connections) + " connection(s)" +
+               (intact ? "" : " CORRUPT"), millis);
+    }
+    std::remove(path.c_str());
+}
+
+// Downloads from a server that cuts every connection after 40 MB, with and without resume
+void resumeDownload() {
+    const std::string content = testContent(200 * 1024 * 1024);
+    std::atomic<int> served{0};
+    TestServer server([&](const TestRequest& request) {
+        ++served;
+        TestReply reply = serveFile(request, content, "\"v1\"");
+        reply.cutAfter = 40 * 1024 * 1024;
+        return reply;
+    });
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_bench.bin").string();
+    curling::RetryPolicy policy;
+    policy.maxAttempts = 10;
+    policy.baseDelay = std::chrono::milliseconds(1);
+    policy.budget = nullptr;
+
+    for (bool resume : {true, false}) {
+        std::remove(path.c_str());
+        served = 0;
+        auto start = Clock::now();
+        std::string outcome;
+        try {
+            curling::Request request;
+            request.setURL(server.url("/file")).downloadToFile(path).setResumeDownload(resume).send(policy);
+            outcome = readFile(path) == content ? "complete" : "CORRUPT";
+        } catch (const curling::RequestException&) {
+            outcome = "failed";
+        }
+        report(std::string("200 MB, cut every 40 MB, ") + (resume ? "resumed" : "restarted") + ": " + outcome +
+               " after " + std::to_string(served.load()) + " attempts", millisSince(start));
+    }
+    std::remove(path.c_str());
+}
+
+// Speed caps set on a Request or inherited from its pool, and the low-speed abort
+void bandwidthLimits() {
+    TestServer server(TestServer::text(std::string(10 * 1024 * 1024, 'x')));
+    auto start = Clock::now();
+    curling::Request capped;
+    capped.setURL(server.url()).setMaxRecvSpeed(5 * 1024 * 1024).send();
+    report("10 MB capped at 5 MB/s on the Request", millisSince(start));
+
+    auto pool = std::make_shared<curling::HandlePool>(1);
+    curling::BandwidthLimits limits;
+    limits.maxRecvBytesPerSecond = 10 * 1024 * 1024;
+    pool->setBandwidthLimits(limits);
+    curling::Request pooled(pool);
+    for (const char* when : {"before", "after"}) {
+        start = Clock::now();
+        pooled.setURL(server.url()).send(); // send() ends with reset()
+        report(std::string("10 MB at the pool's 10 MB/s, ") + when + " reset()", millisSince(start));
+    }
+
+    TestServer silent(TestServer::silent());
+    start = Clock::now();
+    try {
+        curling::Request stalled;
+        stalled.setURL(silent.url()).setLowSpeedLimit(1, std::chrono::seconds(2)).send();
+    } catch (const curling::RequestException&) {
+    }
+    report("silent server, aborted below 1 B/s for 2 s", millisSince(start));
+}
+
+// Many small requests: one after another, then through a Batch twice
+void batch() {
+    for (int latency : {0, 1}) { // server time per request, in ms
+        TestServer server([latency](const TestRequest& request) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(latency));
+            TestReply reply;
+            reply.body = request.path;
+            return reply;
+        });
+        const std::string prefix = std::to_string(latency) + " ms server, ";
+        auto requests = [&server] {
+            std::vector<curling::Request> out(500);
+            for (std::size_t i = 0; i < out.size(); ++i) out[i].setURL(server.url("/item/" + std::to_string(i)));
+            return out;
+        };
+
+        auto start = Clock::now();
+        curling::Request sequential;
+        sequential.setReuseHandle();
+        for (std::size_t i = 0; i < 500; ++i) sequential.setURL(server.url("/item/" + std::to_string(i))).send();
+        report(prefix + "500 requests on one reused handle", millisSince(start));
+
+        curling::Batch batch; // concurrency 16
+        for (const char* run : {"first", "second"}) {
+            int connectionsBefore = server.connections();
+            start = Clock::now();
+            auto results = batch.run(requests());
+            double millis = millisSince(start);
+            bool inOrder = true;
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                inOrder = inOrder && results[i].ok() && results[i].response.body == "/item/" + std::to_string(i);
+            }
+            report(prefix + "Batch of 16, " + run + " run, " +
+                   std::to_string(server.connections() - connectionsBefore) + " new connections" +
+                   (inOrder ? "" : " OUT OF ORDER"), millis);
+        }
+    }
+}
+
+const std::vector<std::pair<const char*, void (*)()>> benchmarks = {
+    {"expect", expectContinue},
+    {"parallel", parallelDownload},
+    {"resume", resumeDownload},
+    {"bandwidth", bandwidthLimits},
+    {"batch", batch},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    for (auto& benchmark : benchmarks) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) selected = selected || std::strcmp(argv[i], benchmark.first) == 0;
+        if (!selected) continue;
+        std::printf("%s\n", benchmark.first);
+        benchmark.second();
+    }
+    return 0;
+}
@@ -16,10 +16,19 @@
  *
  * @section features Features
  * - RAII and smart-pointer-based resource management
- * - MIME support for file uploads
+ * - MIME support for file uploads, and bodies streamed from files, streams or generators
  * - Fluent API for intuitive chaining
  * - Proxy and authentication support
  * - Persistent cookie management
+ * - Connection, DNS and TLS session caches shareable across threads
+ * - Thread-safe pool of warm easy handles for short-lived Requests
+ * - Per-host rate limiting and in-flight caps, blocking or deferred by the engines
+ * - Per-endpoint circuit breaker failing requests fast while a server is down
+ * - Parallel ranged downloads into a preallocated file (Linux)
+ * - Per-transfer bandwidth caps and low-speed aborts, with pool and engine defaults
+ * - Batch runs of many requests on one thread, with a concurrency limit
+ * - Asynchronous Engine running many requests on one curl_multi thread
+ * - epoll-driven SocketEngine embeddable in an existing event loop (Linux)
  *
  * @section example Example
  * @code
@@ -40,8 +49,9 @@
 
 
 /**
- * @note Curling internally manages curl_global_init() and curl_global_cleanup()
- * one cleanup per init.
+ * @note Curling calls curl_global_init() once, on first use, and curl_global_cleanup()
+ * once, at process exit. Call curling::globalInit() early in main() to pay the
+ * initialisation up front, before threads are started.
  */
 
 /**
@@ -74,6 +84,24 @@
 #include <curl/curl.h>
 #include <thread>
 #include <chrono>
+#include <future>
+#include <atomic>
+#include <unordered_map>
+#include <optional>
+#include <string_view>
+#include <random>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 namespace curling {
@@ -140,6 +168,14 @@ public:
     explicit RequestException(const std::string& msg) : CurlingException(msg) {}
 };
 
+/** @class CircuitOpenException
+ * @brief Thrown instead of sending a request while its endpoint's circuit breaker is open.
+ */
+class CircuitOpenException : public RequestException {
+public:
+    explicit CircuitOpenException(const std::string& msg) : RequestException(msg) {}
+};
+
 /** @class HeaderException
  * @brief Thrown when header operations fail.
  */
@@ -164,6 +200,24 @@ public:
     explicit LogicException(const std::string& msg) : CurlingException(msg) {}
 };
 
+/**
+ * @enum SinkAction
+ * @brief What a body sink wants done after receiving a chunk.
+ */
+enum class SinkAction {
+    Continue, ///< Chunk consumed, keep receiving.
+    Pause,    ///< Chunk NOT consumed: pause receiving; it is delivered again after Request::resume().
+              ///< Only with Request::send(): engines and Batch fail the transfer with LogicException.
+    Abort     ///< Abort the transfer (send fails with RequestException).
+};
+
+/** Receives the response body chunk by chunk, as it arrives. */
+using BodySink = std::function<SinkAction(const char* data, size_t size)>;
+
+/** Produces the request body piece by piece: fills at most size bytes of buffer and
+ *  returns how many it wrote, 0 once the body is complete. */
+using BodySource = std::function<size_t(char* buffer, size_t size)>;
+
 inline constexpr int version_major = 1;
 inline constexpr int version_minor = 2;
 inline constexpr int version_patch = 0;
@@ -180,27 +234,29 @@ inline std::string version() {
  */
 namespace detail {
 
-inline std::once_flag curlGlobalInitFlag;
-inline std::mutex curlGlobalMutex;
-
-inline int instanceCount = 0;
-
-inline void ensureCurlGlobalInit() {
-    std::lock_guard<std::mutex> lock(curlGlobalMutex);
-    if (instanceCount++ == 0) {
+struct CurlGlobalState {
+    CurlGlobalState() {
         if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
             throw InitializationException("Failed to initialize libcurl globally");
         }
     }
-}
+    ~CurlGlobalState() { curl_global_cleanup(); }
+};
 
-inline void maybeCleanupGlobalCurl() noexcept {
-    std::lock_guard<std::mutex> lock(curlGlobalMutex);
-    if (--instanceCount == 0) {
-        curl_global_cleanup();
-    }
+inline void ensureCurlGlobalInit() {
+    // Initialised once, by the first caller; afterwards this is a lock-free check.
+    // A failed initialisation throws and is attempted again by the next caller.
+    static const CurlGlobalState state;
+    (void)state;
 }
 
+/** Makes sure curl's global state exists before objects using raw curl handles. */
+struct CurlGlobalGuard {
+    CurlGlobalGuard() { ensureCurlGlobalInit(); }
+    CurlGlobalGuard(const CurlGlobalGuard&) = delete;
+    CurlGlobalGuard& operator=(const CurlGlobalGuard&) = delete;
+};
+
 inline void trim(std::string& s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch){
         return !std::isspace(ch);
@@ -216,18 +272,120 @@ inline void toLowerCase(std::string& s) {
 }
 
 
+/** Response body storage, sized from Content-Length on the first write. */
+struct ResponseBuffer {
+    // the server's Content-Length is not trusted beyond this; larger bodies grow as they arrive
+    static constexpr curl_off_t maxReserve = 4 * 1024 * 1024;
+
+    std::string data;
+    CURL* handle = nullptr;
+    bool sized = false;
+};
+
 inline size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    auto responseStream = static_cast<std::ostringstream*>(userp);
-    responseStream->write(static_cast<char*>(contents), size * nmemb);
+    auto* buffer = static_cast<ResponseBuffer*>(userp);
+    try {
+        if (!buffer->sized) {
+            buffer->sized = true;
+            curl_off_t length = -1;
+            if (curl_easy_getinfo(buffer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length > 0) {
+                length = std::min(length, ResponseBuffer::maxReserve);
+                buffer->data.reserve(buffer->data.size() + static_cast<size_t>(length));
+            }
+        }
+        buffer->data.append(static_cast<char*>(contents), size * nmemb);
+    } catch (const std::exception&) {
+        return 0; // out of memory: abort the transfer rather than unwind through libcurl
+    }
     return size * nmemb;
 }
 
-inline size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
-    auto* headerMap = static_cast<std::map<std::string, std::vector<std::string>>*>(userdata);
-    std::string headerLine(buffer, size * nitems);
+/** Body sink of a transfer; see Request::setBodySink. */
+struct SinkTarget {
+    BodySink* sink = nullptr;
+    bool pausable = true;      // false in engines: the Request was moved in, nobody can resume it
+    bool pauseRefused = false; // the sink asked to pause where it cannot
+    bool received = false;     // the sink has seen body bytes of this attempt
+};
 
-    if (headerLine.empty()) return 0; // skip the separation line
+inline size_t SinkCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    auto* target = static_cast<SinkTarget*>(userp);
+    SinkAction action;
+    target->received = true;
+    try {
+        action = (*target->sink)(static_cast<const char*>(contents), size * nmemb);
+    } catch (...) {
+        return 0; // exceptions must not unwind through libcurl: abort instead
+    }
+    if (action == SinkAction::Pause && !target->pausable) {
+        target->pauseRefused = true;
+        return 0;
+    }
+    switch (action) {
+        case SinkAction::Continue: return size * nmemb;
+        case SinkAction::Pause:    return CURL_WRITEFUNC_PAUSE;
+        case SinkAction::Abort:
+        default:                   return 0;
+    }
+}
+
+/** Download file resumed from its current size; see Request::setResumeDownload. */
+struct ResumeTarget {
+    FILE* file = nullptr;   // opened for appending
+    CURL* handle = nullptr;
+    std::string path;
+    curl_off_t offset = 0;  // bytes already on disk, requested with a Range
+    bool checked = false;   // status looked at
+    bool discard = false;   // error response: keep the partial file as it is
+};
+
+inline size_t ResumeWriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    auto* target = static_cast<ResumeTarget*>(userp);
+    if (!target->checked) {
+        target->checked = true;
+        long code = 0;
+        curl_easy_getinfo(target->handle, CURLINFO_RESPONSE_CODE, &code);
+        if (code < 200 || code >= 300) {
+            target->discard = true;
+        } else if (code != 206 && target->offset > 0) {
+            // range ignored, or the file changed since (If-Range): start over
+            std::error_code ec;
+            std::fflush(target->file);
+            std::filesystem::resize_file(target->path, 0, ec);
+            if (ec) return 0;
+        }
+    }
+    if (target->discard) return size * nmemb;
+    return std::fwrite(contents, 1, size * nmemb, target->file);
+}
+
+/** A streamed request body; seek is empty when the source cannot be replayed. */
+struct UploadSource {
+    BodySource read;
+    std::function<bool(curl_off_t offset)> seek;
+    curl_off_t length = -1; // -1 when unknown: sent chunked
+};
+
+inline size_t ReadCallback(char* buffer, size_t size, size_t nitems, void* userp) {
+    auto* source = static_cast<UploadSource*>(userp);
+    try {
+        return source->read(buffer, size * nitems);
+    } catch (...) {
+        return CURL_READFUNC_ABORT;
+    }
+}
+
+inline int SeekCallback(void* userp, curl_off_t offset, int origin) {
+    auto* source = static_cast<UploadSource*>(userp);
+    if (origin != SEEK_SET || !source->seek) return CURL_SEEKFUNC_CANTSEEK;
+    try {
+        return source->seek(offset) ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+    } catch (...) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+}
 
+inline void parseHeaderLine(const std::string& headerLine, std::map<std::string, std::vector<std::string>>& headerMap) {
     auto colonPos = headerLine.find(":");
     if (colonPos != std::string::npos) {
         std::string key = headerLine.substr(0, colonPos);
@@ -235,43 +393,167 @@ inline size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* use
         detail::trim(key);
         detail::trim(value);
         detail::toLowerCase(key);
-        (*headerMap)[key].push_back(value);
+        headerMap[key].push_back(value);
+    }
+}
+
+/** Values of one header (lowercase name) in a raw header block, without building the whole map. */
+inline std::vector<std::string> findRawHeader(const std::string& raw, const std::string& lowered) {
+    std::vector<std::string> values;
+    std::istringstream lines(raw);
+    std::string line;
+    while (std::getline(lines, line)) {
+        auto colonPos = line.find(':');
+        if (colonPos == std::string::npos) continue;
+        std::string key = line.substr(0, colonPos);
+        detail::trim(key);
+        detail::toLowerCase(key);
+        if (key != lowered) continue;
+        std::string value = line.substr(colonPos + 1);
+        detail::trim(value);
+        values.push_back(std::move(value));
+    }
+    return values;
+}
+
+inline size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* headerMap = static_cast<std::map<std::string, std::vector<std::string>>*>(userdata);
+    std::string headerLine(buffer, size * nitems);
+
+    if (headerLine.empty()) return 0; // skip the separation line
+
+    parseHeaderLine(headerLine, *headerMap);
+
+    return size * nitems;
+}
+
+inline size_t RawHeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* raw = static_cast<std::string*>(userdata);
+    // a status line starts the headers of a new response (redirect, 100-continue): keep the last one
+    if (size * nitems >= 5 && std::equal(buffer, buffer + 5, "HTTP/")) {
+        raw->clear();
     }
+    raw->append(buffer, size * nitems);
+    return size * nitems;
+}
 
+inline size_t DiscardCallback(char*, size_t size, size_t nitems, void*) {
     return size * nitems;
 }
 
 inline int ProgressCallbackBridge(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
                                   curl_off_t ultotal, curl_off_t ulnow);
 
+// "host:port" of a URL, lowercased: the unit of rate limiting and circuit breaking
+inline std::string hostKey(const std::string& url) {
+    std::unique_ptr<CURLU, decltype(&curl_url_cleanup)> parsed(curl_url(), &curl_url_cleanup);
+    if (!parsed || curl_url_set(parsed.get(), CURLUPART_URL, url.c_str(), CURLU_GUESS_SCHEME) != CURLUE_OK) {
+        throw RequestException("Cannot parse URL: " + url);
+    }
+    char* host = nullptr;
+    char* port = nullptr;
+    curl_url_get(parsed.get(), CURLUPART_HOST, &host, 0);
+    curl_url_get(parsed.get(), CURLUPART_PORT, &port, CURLU_DEFAULT_PORT);
+    std::string key = std::string(host ? host : "") + ":" + (port ? port : "");
+    curl_free(host);
+    curl_free(port);
+    toLowerCase(key);
+    return key;
+}
+
 
 }//detail end
 
+/**
+ * @brief Initialises libcurl now instead of on first use. Safe to call repeatedly.
+ * @throws InitializationException if curl_global_init fails.
+ */
+inline void globalInit() {
+    detail::ensureCurlGlobalInit();
+}
+
 
 
 /** SAFETY: RAII deleters for CURL handles */
 struct CurlHandleDeleter { void operator()(CURL* h) const noexcept { if (h) curl_easy_cleanup(h); }};
 struct CurlSlistDeleter { void operator()(curl_slist* l) const noexcept { if (l) curl_slist_free_all(l); }};
 struct CurlMimeDeleter { void operator()(curl_mime* m) const noexcept { if (m) curl_mime_free(m); }};
+struct CurlMultiDeleter { void operator()(CURLM* m) const noexcept { if (m) curl_multi_cleanup(m); }};
+struct CurlShareDeleter { void operator()(CURLSH* s) const noexcept { if (s) curl_share_cleanup(s); }};
 struct FileCloser { void operator()(FILE* file) const noexcept { if (file) std::fclose(file); }};
 
 using CurlPtr = std::unique_ptr<CURL, CurlHandleDeleter>;
 using CurlSlistPtr = std::unique_ptr<curl_slist, CurlSlistDeleter>;
 using CurlMimePtr = std::unique_ptr<curl_mime, CurlMimeDeleter>;
+using CurlMultiPtr = std::unique_ptr<CURLM, CurlMultiDeleter>;
+using CurlSharePtr = std::unique_ptr<CURLSH, CurlShareDeleter>;
 using FilePtr = std::unique_ptr<FILE, FileCloser>;
 
 
+/**
+ * @struct TransferInfo
+ * @brief Where the time of a transfer went, as measured by libcurl.
+ *
+ * Phase times are cumulative from the start of the transfer: connect includes
+ * nameLookup, startTransfer includes preTransfer, and so on. With redirects they
+ * cover the last request only, and redirect holds the time spent before it.
+ */
+struct TransferInfo {
+    std::chrono::microseconds nameLookup{0};    ///< DNS resolution done.
+    std::chrono::microseconds connect{0};       ///< TCP (or Unix socket) connection established.
+    std::chrono::microseconds appConnect{0};    ///< TLS handshake done (0 without TLS).
+    std::chrono::microseconds preTransfer{0};   ///< Request about to be sent.
+    std::chrono::microseconds startTransfer{0}; ///< First response byte received.
+    std::chrono::microseconds total{0};         ///< Transfer complete.
+    std::chrono::microseconds redirect{0};      ///< Time spent following redirects.
+    long redirectCount = 0;
+    curl_off_t bytesUploaded = 0;   ///< Request body bytes sent.
+    curl_off_t bytesDownloaded = 0; ///< Response body bytes received, before decompression.
+    long newConnections = 0;        ///< Connections opened for this transfer.
+
+    /** @brief True when the transfer ran over an already open connection. */
+    bool connectionReused() const noexcept { return newConnections == 0; }
+
+    /** @brief Time from sending the request to its first response byte: the server's share. */
+    std::chrono::microseconds serverTime() const noexcept { return startTransfer - preTransfer; }
+};
+
+namespace detail {
+inline TransferInfo readTransferInfo(CURL* handle) {
+    TransferInfo info;
+    auto time = [handle](CURLINFO what) {
+        curl_off_t us = 0;
+        curl_easy_getinfo(handle, what, &us);
+        return std::chrono::microseconds(us);
+    };
+    info.nameLookup = time(CURLINFO_NAMELOOKUP_TIME_T);
+    info.connect = time(CURLINFO_CONNECT_TIME_T);
+    info.appConnect = time(CURLINFO_APPCONNECT_TIME_T);
+    info.preTransfer = time(CURLINFO_PRETRANSFER_TIME_T);
+    info.startTransfer = time(CURLINFO_STARTTRANSFER_TIME_T);
+    info.total = time(CURLINFO_TOTAL_TIME_T);
+    info.redirect = time(CURLINFO_REDIRECT_TIME_T);
+    curl_easy_getinfo(handle, CURLINFO_REDIRECT_COUNT, &info.redirectCount);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD_T, &info.bytesUploaded);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &info.bytesDownloaded);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &info.newConnections);
+    return info;
+}
+} // namespace detail
+
 /**
  * @struct Response
  * @brief Represents an HTTP response.
  *
- * Contains the HTTP status code, body, and headers.
+ * Contains the HTTP status code, body, headers and transfer timing.
  */
 struct Response {
     long httpCode; ///< HTTP status code.
     std::string body; ///< Response body.
     std::map<std::string, std::vector<std::string>> headers; ///< Header map (key: lowercase).
-    
+    std::string rawHeaders; ///< Unparsed header block, filled instead of headers with HeaderMode::Raw.
+    TransferInfo info; ///< Timing, byte counts and connection reuse of the transfer.
+
     std::string toString() const {
         std::ostringstream oss;
         oss << "status: " << httpCode << "\nbody:\n" << body << "\nheaders:\n";
@@ -280,175 +562,791 @@ struct Response {
             for (auto const& v : h.second) oss << v << " ";
             oss << "\n";
         }
+        oss << rawHeaders;
         return oss.str();
     }
     std::vector<std::string> getHeader(const std::string& key) const {
         std::string lowered = key;
         detail::toLowerCase(lowered);
+        if (headers.empty() && !rawHeaders.empty()) {
+            return detail::findRawHeader(rawHeaders, lowered); // HeaderMode::Raw: scans, caches nothing
+        }
         auto it = headers.find(lowered);
         return (it != headers.end()) ? it->second : std::vector<std::string>{};
     }
+    /**
+     * @brief Fills headers from rawHeaders, for responses received with HeaderMode::Raw.
+     *
+     * getHeader() scans rawHeaders on each call; parse once here before many lookups.
+     * Does nothing if headers is already filled, so calling it twice is harmless.
+     */
+    void parseHeaders() {
+        if (!headers.empty()) return;
+        std::istringstream lines(rawHeaders);
+        std::string line;
+        while (std::getline(lines, line)) {
+            detail::parseHeaderLine(line, headers);
+        }
+    }
 };
 
+namespace detail {
+/** Validator to send as If-Range for what response delivered: its strong ETag
+ *  (weak ones are not allowed there), else its Last-Modified, else empty. */
+inline std::string ifRangeValidator(const Response& response) {
+    auto etag = response.getHeader("ETag");
+    if (!etag.empty() && etag.back().rfind("W/", 0) != 0) return etag.back();
+    auto modified = response.getHeader("Last-Modified");
+    return modified.empty() ? std::string() : modified.back();
+}
+
+/** Resource length a 416 reports in its Content-Range, -1 if absent. */
+inline curl_off_t unsatisfiedRangeLength(const Response& response) {
+    auto range = response.getHeader("Content-Range");
+    if (range.empty() || range.back().rfind("bytes */", 0) != 0) return -1;
+    return std::strtoll(range.back().c_str() + 8, nullptr, 10);
+}
+} // namespace detail
+
 /**
- * @class Request
- * @brief Provides a fluent wrapper for HTTP requests via libcurl.
+ * @class RetryBudget
+ * @brief Token bucket bounding how many retries may happen, shared by many requests.
+ *
+ * Every retry takes a token; tokens refill at a fixed rate up to a burst size. When
+ * a dependency fails for everyone at once, the budget runs dry and requests fail
+ * fast instead of multiplying the load with retries. Thread-safe.
  */
-class Request {
+class RetryBudget {
 public:
-    using ProgressCallback = std::function<bool(curl_off_t dltotal, curl_off_t dlnow,
-                                                curl_off_t ultotal, curl_off_t ulnow)>;
-
     /**
-     * @enum Method
-     * @brief Supported HTTP methods.
+     * @param burst Retries allowed back to back when the bucket is full.
+     * @param perSecond Retries regained per second.
      */
-    enum class Method {
-        GET,    ///< Standard GET
-        POST,   ///< Standard POST
-        PUT,    ///< PUT
-        DEL,    ///< DELETE (named DEL to avoid macro clash)
-        PATCH,  ///< PATCH
-        HEAD,   ///< HEAD request just headers
-        MIME    ///< Multipart/form-data POST
-    };
+    explicit RetryBudget(double burst = 100, double perSecond = 10)
+        : capacity(burst), rate(perSecond), tokens(burst), last(std::chrono::steady_clock::now()) {}
 
     /**
-     * @enum AuthMethod
-     * @brief HTTP authentication schemes.
+     * @brief Budget shared by the whole process.
      */
-    enum class AuthMethod {
-        BASIC = CURLAUTH_BASIC,
-        NTLM = CURLAUTH_NTLM,
-        DIGEST = CURLAUTH_DIGEST
-    };
+    static const std::shared_ptr<RetryBudget>& process() {
+        static const auto budget = std::make_shared<RetryBudget>();
+        return budget;
+    }
 
     /**
-    * @enum HttpVersion
-    * @brief Specifies the HTTP version to be used for the request.
-    *
-    * Allows explicit control over the HTTP version that libcurl should use
-    * when performing a request. If the selected version is not supported
-    * by the libcurl build or the server, fallback behavior may occur.
-    *
-    * @note If you request a version not supported by libcurl at runtime,
-    * Curling will throw a LogicException during configuration.
-    * If the server doesn't support the version (e.g., HTTP/2),
-    * libcurl may fall back to an older version without error.
-    */
-    enum class HttpVersion {
-        DEFAULT,   ///< Let libcurl automatically negotiate the best supported HTTP version.
-        HTTP_1_1,  ///< Force HTTP/1.1 for all requests.
-        HTTP_2,    ///< Force HTTP/2 (requires libcurl built with nghttp2 support).
-        HTTP_3     ///< Force HTTP/3 (requires libcurl built with HTTP/3 support, e.g. with quiche or ngtcp2).
-    };
+     * @brief Takes one token if available.
+     * @return True if a retry may proceed.
+     */
+    bool tryAcquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        tokens = std::min(capacity, tokens + std::chrono::duration<double>(now - last).count() * rate);
+        last = now;
+        if (tokens < 1) return false;
+        tokens -= 1;
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    double capacity, rate, tokens;
+    std::chrono::steady_clock::time_point last;
+};
+
+/**
+ * @struct RetryPolicy
+ * @brief Decides whether and when Request::send retries.
+ *
+ * Delays grow exponentially from baseDelay up to maxDelay and are randomized by
+ * jitter so that clients failing together do not retry together. A Retry-After
+ * received with a retried status is honoured as a minimum delay; one longer than
+ * maxDelay ends the retries, as it would be cut short otherwise.
+ *
+ * POST, PATCH and multipart requests are only retried when they certainly did not
+ * reach the server (connect/resolve errors, 429), unless retryNonIdempotent is set.
+ */
+struct RetryPolicy {
+    unsigned maxAttempts = 3;                       ///< Attempts in total, including the first.
+    std::chrono::milliseconds baseDelay{200};       ///< Delay before the first retry.
+    std::chrono::milliseconds maxDelay{10000};      ///< Upper bound of a single delay.
+    double jitter = 0.5;                            ///< Fraction of each delay that is randomized (0..1).
+    std::chrono::milliseconds deadline{0};          ///< No retry starts after this time since send(); 0 for none.
+    std::vector<long> retryStatuses{429, 502, 503, 504}; ///< HTTP statuses treated as transient.
+    bool retryNonIdempotent = false;                ///< Also retry POST/PATCH/MIME after they may have been processed.
+    std::shared_ptr<RetryBudget> budget = RetryBudget::process(); ///< Shared retry allowance, nullptr for unlimited.
 
     /**
-     * @brief Constructor initializes curl global state.
-     * @throws InitializationException if initialization fails.
+     * @brief Delay before the given retry.
+     * @param retry 1 for the first retry.
+     * @param retryAfter Server-requested delay, 0 if none.
+     * @return The backoff delay, at least retryAfter, at most maxDelay.
      */
-    Request();
+    std::chrono::milliseconds delayFor(unsigned retry, std::chrono::milliseconds retryAfter = {}) const {
+        thread_local std::mt19937 rng(std::random_device{}());
+        double delay = static_cast<double>(baseDelay.count()) * std::pow(2.0, static_cast<double>(retry - 1));
+        delay = std::min(delay, static_cast<double>(maxDelay.count()));
+        double spread = std::clamp(jitter, 0.0, 1.0);
+        delay *= 1.0 - spread * std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        auto result = std::chrono::milliseconds(static_cast<long long>(delay));
+        return std::min(std::max(result, retryAfter), maxDelay);
+    }
+
+    bool isRetryStatus(long httpCode) const {
+        return std::find(retryStatuses.begin(), retryStatuses.end(), httpCode) != retryStatuses.end();
+    }
+};
 
+/**
+ * @class RateLimiter
+ * @brief Per-host token bucket and cap on requests in flight, shared by many requests.
+ *
+ * Each host (scheme-less "host:port") gets its own bucket of `burst` tokens refilled
+ * at `perSecond`, and at most `maxInFlight` admitted requests at a time. A request
+ * is admitted by taking a Permit, which holds its in-flight slot until released.
+ * acquire() blocks; tryAcquire() and admissionDelay() let event-driven callers
+ * defer work instead. Hosts that are idle with a full bucket are forgotten as the
+ * map grows, so a limiter shared across many hosts stays small. Thread-safe.
+ */
+class RateLimiter {
+public:
     /**
-     * @brief Destructor cleans up curl state if last instance.
+     * @brief Admission of one request to a host; frees its in-flight slot when destroyed.
+     * @warning Must not outlive the RateLimiter that issued it.
      */
-    ~Request() noexcept;
+    class Permit {
+    public:
+        Permit(Permit&& other) noexcept : limiter(other.limiter), host(std::move(other.host)) {
+            other.limiter = nullptr;
+        }
+        Permit& operator=(Permit&& other) noexcept {
+            if (this != &other) {
+                release();
+                limiter = other.limiter;
+                host = std::move(other.host);
+                other.limiter = nullptr;
+            }
+            return *this;
+        }
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+        ~Permit() { release(); }
 
-    Request(Request&&) noexcept;
-    Request& operator=(Request&&) noexcept;
+        /** @brief Frees the in-flight slot early. */
+        void release() noexcept;
 
-    Request(const Request&) = delete;
-    Request& operator=(const Request&) = delete;
+    private:
+        friend class RateLimiter;
+        Permit(RateLimiter* limiter, std::string host) : limiter(limiter), host(std::move(host)) {}
+
+        RateLimiter* limiter;
+        std::string host;
+    };
 
     /**
-     * @brief Sets the progress callback function.
-     * @param cb Callback receiving download/upload progress. Return true to abort.
-     * @return *this
+     * @param perSecond Requests admitted per second and host, 0 for no rate limit.
+     * @param burst Requests admitted back to back when the bucket is full.
+     * @param maxInFlight Concurrent requests per host, 0 for unlimited.
      */
-    Request& setProgressCallback(ProgressCallback cb);
+    explicit RateLimiter(double perSecond, double burst = 1, std::size_t maxInFlight = 0)
+        : rate(perSecond), capacity(std::max(burst, 1.0)), maxInFlight(maxInFlight) {}
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
 
     /**
-     * @brief Sets the HTTP method for the request.
-     * @param m Enum value for HTTP method.
-     * @return *this
+     * @brief Admits a request to host if a token and a slot are free, without waiting.
      */
-    Request& setMethod(Method m);
+    std::optional<Permit> tryAcquire(const std::string& host);
 
     /**
-     * @brief Sets the request URL.
-     * @param url URL to fetch.
-     * @return *this
+     * @brief Waits until a request to host can be admitted.
      */
-    Request& setURL(const std::string& url);
+    Permit acquire(const std::string& host);
 
     /**
-     * @brief Enables proxy usage.
-     * @param url Proxy URL.
-     * @return *this
+     * @brief How long until tryAcquire(host) may succeed: 0 when it would now.
+     *
+     * When the host is at its in-flight cap the wait depends on other requests
+     * finishing, so a short re-check interval is returned.
      */
-    Request& setProxy(const std::string& url);
+    std::chrono::milliseconds admissionDelay(const std::string& host);
 
     /**
-     * @brief Sets credentials for proxy authentication.
-     * @param username Proxy username.
-     * @param password Proxy password.
-     * @return *this
+     * @brief Key under which a URL is limited: "host:port".
+     * @throws RequestException if the URL cannot be parsed.
      */
-    Request& setProxyAuth(const std::string& username, const std::string& password);
+    static std::string hostOf(const std::string& url) { return detail::hostKey(url); }
 
     /**
-     * @brief Sets proxy authentication scheme.
-     * @param method Authentication method.
-     * @return *this
+     * @brief Number of hosts the limiter currently keeps state for.
      */
-    Request& setProxyAuthMethod(AuthMethod method);
+    std::size_t trackedHosts() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hosts.size();
+    }
+
+private:
+    struct Host {
+        double tokens;
+        std::chrono::steady_clock::time_point last;
+        std::size_t inFlight = 0;
+    };
+
+    static constexpr std::chrono::milliseconds recheckInterval{10};
+    static constexpr std::size_t minEvictionSize = 64;
+
+    double rate, capacity;
+    std::size_t maxInFlight;
+    std::mutex mutex;
+    std::condition_variable released;
+    std::unordered_map<std::string, Host> hosts;
+    std::size_t evictAt = minEvictionSize; // map size that triggers the next sweep
+
+    Host& refill(const std::string& host); // with mutex held
+    void evictIdle(std::chrono::steady_clock::time_point now); // with mutex held
+    std::chrono::milliseconds delayFor(const Host& state) const;
+    void release(const std::string& host) noexcept;
+};
+
+/**
+ * @class CircuitBreaker
+ * @brief Fails requests fast while their endpoint ("host:port") keeps failing.
+ *
+ * Closed: requests flow and consecutive failures are counted. After
+ * `failureThreshold` of them the circuit opens and requests throw
+ * CircuitOpenException without touching the network. Once `probeInterval` has
+ * passed, one probe request is let through (half-open): its success closes the
+ * circuit, its failure opens it for another interval. Failures are transfers that
+ * could not reach the endpoint (connect, DNS, timeout, broken connection) and
+ * 502/503/504 responses. Thread-safe.
+ */
+class CircuitBreaker {
+public:
+    enum class State { Closed, Open, HalfOpen };
 
     /**
-     * @brief Sets credentials for HTTP auth (Basic/Digest/NTLM).
-     * @param username Username.
-     * @param password Password.
-     * @return *this
+     * @param failureThreshold Consecutive failures that open the circuit.
+     * @param probeInterval Time an open circuit waits before letting a probe through.
      */
-    Request& setHttpAuth(const std::string& username, const std::string& password);
+    explicit CircuitBreaker(unsigned failureThreshold = 5,
+                            std::chrono::milliseconds probeInterval = std::chrono::seconds(10))
+        : threshold(std::max(failureThreshold, 1u)), interval(probeInterval) {}
+
+    CircuitBreaker(const CircuitBreaker&) = delete;
+    CircuitBreaker& operator=(const CircuitBreaker&) = delete;
 
     /**
-     * @brief Sets HTTP authentication scheme.
-     * @param method Authentication method.
-     * @return *this
+     * @brief Breaker shared by the whole process.
      */
-    Request& setHttpAuthMethod(AuthMethod method);
+    static const std::shared_ptr<CircuitBreaker>& process() {
+        static const auto breaker = std::make_shared<CircuitBreaker>();
+        return breaker;
+    }
 
     /**
-     * @brief Adds a query parameter to the URL.
-     * @param key Parameter name.
-     * @param value Parameter value.
-     * @return *this
+     * @brief Whether a request to endpoint may go out now.
+     *
+     * Moves an open circuit whose interval has passed to half-open and admits the
+     * caller as its probe; the caller must report the outcome with record().
      */
-    Request& addArg(const std::string& key, const std::string& value);
+    bool allow(const std::string& endpoint);
 
     /**
-     * @brief Adds a custom HTTP header.
-     * @param header A full header line, e.g. "Accept: application/json".
-     * @return *this
+     * @brief Reports the outcome of a request admitted by allow().
      */
-    Request& addHeader(const std::string& header);
+    void record(const std::string& endpoint, bool success);
+
+    State state(const std::string& endpoint);
+
+    /** @brief True for transfer results that say the endpoint is unreachable or unhealthy. */
+    static bool isFailure(CURLcode result, long httpCode) noexcept;
+
+private:
+    struct Endpoint {
+        State state = State::Closed;
+        unsigned failures = 0;
+        std::chrono::steady_clock::time_point since; // opened, or probe started
+    };
 
+    unsigned threshold;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::unordered_map<std::string, Endpoint> endpoints;
+};
+
+/**
+ * @class SharedCache
+ * @brief DNS, connection and TLS session caches shared between Requests.
+ *
+ * Wraps a curl share handle with one mutex per shared data kind, so Requests
+ * living on different threads can resolve, connect and handshake once and reuse
+ * the result. Requests keep the cache alive through a shared_ptr.
+ */
+class SharedCache {
+public:
     /**
-     * @brief Sets the body of the request (for POST/PUT/PATCH).
-     * @param body Request body content.
-     * @return *this
+     * @brief Creates the share handle and installs its lock callbacks.
+     * @param maxConnections Idle connections kept open in the shared pool.
+     * @throws InitializationException if the share handle cannot be created.
      */
-    Request& setBody(const std::string& body);
+    explicit SharedCache(long maxConnections = 64);
+
+    SharedCache(const SharedCache&) = delete;
+    SharedCache& operator=(const SharedCache&) = delete;
 
     /**
-     * @brief Enables download streaming to a file.
-     * @param path Local file path for saving response.
-     * @return *this
+     * @brief Raw share handle, for use with CURLOPT_SHARE.
      */
-    Request& downloadToFile(const std::string& path);
+    CURLSH* handle() const noexcept { return share.get(); }
 
     /**
-     * @brief Sets a timeout for the request (in seconds).
+     * @brief Size of the shared connection pool.
+     */
+    long maxConnections() const noexcept { return poolSize; }
+
+private:
+    detail::CurlGlobalGuard curlGlobal;
+    long poolSize;
+    std::mutex locks[CURL_LOCK_DATA_LAST];
+    CurlSharePtr share;
+
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr);
+    static void unlock(CURL*, curl_lock_data data, void* userptr);
+};
+
+/**
+ * @struct BandwidthLimits
+ * @brief Speed caps and low-speed abort of a transfer; 0 disables each of them.
+ *
+ * libcurl enforces these per transfer: a pool or engine default caps each of its
+ * transfers separately, not their sum.
+ */
+struct BandwidthLimits {
+    curl_off_t maxRecvBytesPerSecond = 0; ///< Download speed cap (CURLOPT_MAX_RECV_SPEED_LARGE).
+    curl_off_t maxSendBytesPerSecond = 0; ///< Upload speed cap (CURLOPT_MAX_SEND_SPEED_LARGE).
+    long lowSpeedBytesPerSecond = 0;      ///< Abort when slower than this...
+    std::chrono::seconds lowSpeedTime{0}; ///< ...for this long (CURLOPT_LOW_SPEED_LIMIT/TIME).
+
+    /** @brief These limits, with the ones left at 0 taken from defaults. */
+    BandwidthLimits orDefaults(const BandwidthLimits& defaults) const {
+        BandwidthLimits merged = *this;
+        if (!merged.maxRecvBytesPerSecond) merged.maxRecvBytesPerSecond = defaults.maxRecvBytesPerSecond;
+        if (!merged.maxSendBytesPerSecond) merged.maxSendBytesPerSecond = defaults.maxSendBytesPerSecond;
+        if (!merged.lowSpeedBytesPerSecond && !merged.lowSpeedTime.count()) {
+            merged.lowSpeedBytesPerSecond = defaults.lowSpeedBytesPerSecond;
+            merged.lowSpeedTime = defaults.lowSpeedTime;
+        }
+        return merged;
+    }
+};
+
+/**
+ * @class HandlePool
+ * @brief Thread-safe pool of idle curl easy handles.
+ *
+ * A Request constructed from a pool takes a handle from it and gives it back when
+ * destroyed. Handles are reset (options cleared) on the way back but keep their
+ * connection, DNS and TLS session caches, so short-lived Requests start warm.
+ * Requests keep the pool alive through a shared_ptr.
+ */
+class HandlePool {
+public:
+    /**
+     * @param capacity Idle handles kept at most; handles returned beyond it are freed.
+     * @param cache Optional cache attached to every Request built from this pool.
+     */
+    explicit HandlePool(size_t capacity = 16, std::shared_ptr<SharedCache> cache = nullptr);
+
+    HandlePool(const HandlePool&) = delete;
+    HandlePool& operator=(const HandlePool&) = delete;
+
+    /**
+     * @brief Creates handles up front so the first Requests skip curl_easy_init.
+     * @param count Idle handles wanted, capped at the capacity.
+     * @throws InitializationException if a handle cannot be created.
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Takes an idle handle, or creates one if none is left.
+     *
+     * The handle comes attached to the pool's shared cache, if any.
+     * @throws InitializationException if a handle cannot be created.
+     */
+    CurlPtr acquire();
+
+    /**
+     * @brief Resets a handle and keeps it for reuse, or frees it if the pool is full.
+     *
+     * The handle is detached from whatever shared cache it used, which may be
+     * destroyed while the handle sits in the pool.
+     */
+    void release(CurlPtr handle) noexcept;
+
+    /**
+     * @brief Number of idle handles.
+     */
+    size_t idle() const;
+
+    size_t capacity() const noexcept { return maxIdle; }
+    const std::shared_ptr<SharedCache>& sharedCache() const noexcept { return cache; }
+
+    /**
+     * @brief Default bandwidth limits of Requests built from this pool, each on its own.
+     */
+    void setBandwidthLimits(const BandwidthLimits& limits);
+    BandwidthLimits bandwidthLimits() const;
+
+private:
+    detail::CurlGlobalGuard curlGlobal;
+    size_t maxIdle;
+    std::shared_ptr<SharedCache> cache;
+    mutable std::mutex mutex;
+    std::vector<CurlPtr> handles;
+    BandwidthLimits limits;
+};
+
+/**
+ * @struct TransportProfile
+ * @brief Socket and protocol tuning applied to a Request as a unit.
+ *
+ * The defaults match libcurl's. lowLatency() is meant for chatty request/response
+ * traffic to a nearby server, such as a local WebDriver.
+ */
+struct TransportProfile {
+    bool tcpNoDelay = true;       ///< Disable Nagle's algorithm so small requests leave at once.
+    bool expectContinue = true;   ///< Let libcurl send "Expect: 100-continue" before large bodies
+                                  ///< (one extra round trip, up to a 1s stall if the server ignores it).
+    bool tcpKeepAlive = false;    ///< Send TCP keepalive probes on idle connections.
+    std::chrono::seconds keepAliveIdle{60};     ///< Idle time before the first probe.
+    std::chrono::seconds keepAliveInterval{60}; ///< Time between probes.
+    long receiveBufferSize = 0;   ///< Receive buffer in bytes (CURLOPT_BUFFERSIZE), 0 for libcurl's default.
+    long uploadBufferSize = 0;    ///< Upload buffer in bytes (CURLOPT_UPLOAD_BUFFERSIZE), 0 for libcurl's default.
+
+    /**
+     * @brief Profile for low-latency exchanges with a nearby server: no Nagle, no
+     * Expect: 100-continue, keepalive probes and large buffers.
+     */
+    static TransportProfile lowLatency() {
+        TransportProfile profile;
+        profile.expectContinue = false;
+        profile.tcpKeepAlive = true;
+        profile.keepAliveIdle = std::chrono::seconds(30);
+        profile.keepAliveInterval = std::chrono::seconds(15);
+        profile.receiveBufferSize = 256 * 1024; // screenshots and page sources in fewer callbacks
+        profile.uploadBufferSize = 256 * 1024;
+        return profile;
+    }
+};
+
+struct EngineOptions;
+
+/**
+ * @class Request
+ * @brief Provides a fluent wrapper for HTTP requests via libcurl.
+ */
+class Request {
+public:
+    using ProgressCallback = std::function<bool(curl_off_t dltotal, curl_off_t dlnow,
+                                                curl_off_t ultotal, curl_off_t ulnow)>;
+
+    /**
+     * @enum Method
+     * @brief Supported HTTP methods.
+     */
+    enum class Method {
+        GET,    ///< Standard GET
+        POST,   ///< Standard POST
+        PUT,    ///< PUT
+        DEL,    ///< DELETE (named DEL to avoid macro clash)
+        PATCH,  ///< PATCH
+        HEAD,   ///< HEAD request just headers
+        MIME    ///< Multipart/form-data POST
+    };
+
+    /**
+     * @enum AuthMethod
+     * @brief HTTP authentication schemes.
+     */
+    enum class AuthMethod {
+        BASIC = CURLAUTH_BASIC,
+        NTLM = CURLAUTH_NTLM,
+        DIGEST = CURLAUTH_DIGEST
+    };
+
+    /**
+    * @enum HttpVersion
+    * @brief Specifies the HTTP version to be used for the request.
+    *
+    * Allows explicit control over the HTTP version that libcurl should use
+    * when performing a request. If the selected version is not supported
+    * by the libcurl build or the server, fallback behavior may occur.
+    *
+    * @note If you request a version not supported by libcurl at runtime,
+    * Curling will throw a LogicException during configuration.
+    * If the server doesn't support the version (e.g., HTTP/2),
+    * libcurl may fall back to an older version without error.
+    */
+    enum class HttpVersion {
+        DEFAULT,   ///< Let libcurl automatically negotiate the best supported HTTP version.
+        HTTP_1_1,  ///< Force HTTP/1.1 for all requests.
+        HTTP_2,    ///< Force HTTP/2 (requires libcurl built with nghttp2 support).
+        HTTP_3,    ///< Force HTTP/3 (requires libcurl built with HTTP/3 support, e.g. with quiche or ngtcp2).
+        HTTP_2_PRIOR_KNOWLEDGE ///< HTTP/2 without HTTP/1.1 upgrade, also over cleartext (h2c).
+    };
+
+    /**
+     * @enum HeaderMode
+     * @brief How response headers are collected.
+     */
+    enum class HeaderMode {
+        Parsed, ///< Split into Response::headers as they arrive (default).
+        Raw,    ///< Kept as one block in Response::rawHeaders, scanned by getHeader().
+        None    ///< Discarded.
+    };
+
+    /**
+     * @brief Constructor initializes curl global state on first use.
+     * @throws InitializationException if initialization fails.
+     */
+    Request();
+
+    /**
+     * @brief Constructs a Request on a warm handle taken from a pool.
+     *
+     * The handle goes back to the pool when the Request is destroyed, and reset()
+     * keeps it as in handle reuse mode. The pool's shared cache, if any, is attached.
+     * @param pool Pool to take the handle from.
+     * @throws LogicException if pool is null.
+     * @throws InitializationException if a new handle is needed and cannot be created.
+     */
+    explicit Request(std::shared_ptr<HandlePool> pool);
+
+    /**
+     * @brief Destructor releases the curl handle (back to its pool, if any) and its resources.
+     */
+    ~Request() noexcept;
+
+    Request(Request&&) noexcept;
+    Request& operator=(Request&&) noexcept;
+
+    Request(const Request&) = delete;
+    Request& operator=(const Request&) = delete;
+
+    /**
+     * @brief Sets the progress callback function.
+     * @param cb Callback receiving download/upload progress. Return true to abort.
+     * @return *this
+     */
+    Request& setProgressCallback(ProgressCallback cb);
+
+    /**
+     * @brief Sets the HTTP method for the request.
+     * @param m Enum value for HTTP method.
+     * @return *this
+     */
+    Request& setMethod(Method m);
+
+    /**
+     * @brief Sets the request URL.
+     * @param url URL to fetch.
+     * @return *this
+     */
+    Request& setURL(const std::string& url);
+
+    /**
+     * @brief Connects through a Unix domain socket instead of TCP.
+     *
+     * The URL still selects the scheme, Host header and path, e.g.
+     * "http://localhost/status" sent over "/run/driver.sock".
+     * @param path Filesystem path of the socket.
+     * @return *this
+     */
+    Request& setUnixSocketPath(const std::string& path);
+
+    /**
+     * @brief Requests only part of the resource (Range: bytes=first-last).
+     * @param first Offset of the first byte.
+     * @param last Offset of the last byte, inclusive, or -1 for the rest of the resource.
+     * @return *this
+     */
+    Request& setRange(curl_off_t first, curl_off_t last = -1);
+
+    /**
+     * @brief Enables proxy usage.
+     * @param url Proxy URL.
+     * @return *this
+     */
+    Request& setProxy(const std::string& url);
+
+    /**
+     * @brief Sets credentials for proxy authentication.
+     * @param username Proxy username.
+     * @param password Proxy password.
+     * @return *this
+     */
+    Request& setProxyAuth(const std::string& username, const std::string& password);
+
+    /**
+     * @brief Sets proxy authentication scheme.
+     * @param method Authentication method.
+     * @return *this
+     */
+    Request& setProxyAuthMethod(AuthMethod method);
+
+    /**
+     * @brief Sets credentials for HTTP auth (Basic/Digest/NTLM).
+     * @param username Username.
+     * @param password Password.
+     * @return *this
+     */
+    Request& setHttpAuth(const std::string& username, const std::string& password);
+
+    /**
+     * @brief Sets HTTP authentication scheme.
+     * @param method Authentication method.
+     * @return *this
+     */
+    Request& setHttpAuthMethod(AuthMethod method);
+
+    /**
+     * @brief Adds a query parameter to the URL.
+     * @param key Parameter name.
+     * @param value Parameter value.
+     * @return *this
+     */
+    Request& addArg(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Adds a custom HTTP header.
+     * @param header A full header line, e.g. "Accept: application/json".
+     * @return *this
+     */
+    Request& addHeader(const std::string& header);
+
+    /**
+     * @brief Sets the body of the request (for POST/PUT/PATCH).
+     * @param body Request body content, copied once into the Request.
+     * @return *this
+     */
+    Request& setBody(const std::string& body);
+
+    /**
+     * @brief Sets the body of the request, taking over the string without copying.
+     * @param body Request body content.
+     * @return *this
+     */
+    Request& setBody(std::string&& body);
+
+    /**
+     * @brief Sets the body of the request from caller-owned memory, without copying.
+     * @param body View of the content. It must stay valid and unchanged until the
+     * transfer completes (send() returns, or an engine reports completion).
+     * @return *this
+     */
+    Request& setBodyView(std::string_view body);
+
+    /**
+     * @brief Streams the request body from a generator instead of memory.
+     *
+     * libcurl calls the source whenever it can send more, so the body never has
+     * to be held in memory. A generator cannot be replayed: send() does not retry
+     * once it has been read from.
+     * @param source Chunk producer. Exceptions it throws abort the transfer.
+     * @param length Total size in bytes, or -1 to send it chunked.
+     * @return *this
+     */
+    Request& setBodySource(BodySource source, curl_off_t length = -1);
+
+    /**
+     * @brief Streams the request body from a file, with its size as Content-Length.
+     *
+     * Regular files are rewound for retries and redirects. Others, such as pipes,
+     * have no size: they are sent chunked, once.
+     * @param path File to upload. It is opened here and read as the transfer progresses.
+     * @return *this
+     * @throws RequestException if the file cannot be opened or its size read.
+     */
+    Request& setBodyFile(const std::string& path);
+
+    /**
+     * @brief Streams the request body from an input stream.
+     * @param in Stream to read from. It must outlive the transfer. Seekable streams
+     * are rewound for retries and redirects.
+     * @param length Bytes to send, or -1 to read until end of stream and send chunked.
+     * @return *this
+     */
+    Request& setBodyStream(std::istream& in, curl_off_t length = -1);
+
+    /**
+     * @brief Chooses how response headers are collected.
+     * @param mode Raw or None avoid per-header allocations when headers are rarely read.
+     * @return *this
+     */
+    Request& setHeaderMode(HeaderMode mode);
+
+    /**
+     * @brief Enables download streaming to a file.
+     * @param path Local file path for saving response.
+     * @return *this
+     */
+    Request& downloadToFile(const std::string& path);
+
+    /**
+     * @brief Resumes downloadToFile() from what the file already holds.
+     *
+     * Each attempt, including send()'s retries, appends to the file and requests only
+     * the missing tail with a Range. The ETag or Last-Modified of the previous attempt
+     * (or the validator given here) is sent as If-Range, so a file that changed on the
+     * server is downloaded again from the start instead of being spliced. Error
+     * responses leave the partial file untouched. A file that is already complete,
+     * answered with a 416 whose Content-Range gives the file's size, is reported as 200.
+     * @note Validators are read from response headers: keep HeaderMode::Parsed or Raw.
+     * @param resume True to resume.
+     * @param validator ETag or Last-Modified of the partial file from an earlier run, if known.
+     * @return *this
+     */
+    Request& setResumeDownload(bool resume = true, std::string validator = "");
+
+    /**
+     * @brief Streams the response body to a sink instead of Response::body.
+     *
+     * The sink sees each chunk as libcurl receives it, so bodies of any size are
+     * processed in constant memory. Returning SinkAction::Pause applies backpressure:
+     * the transfer stops reading until resume() is called. Engines and Batch take
+     * the Request over, so nothing could resume it there: a sink returning Pause
+     * fails their transfer with LogicException. send(const RetryPolicy&) does not
+     * retry once the sink has received bytes: they cannot be taken back.
+     * @param sink Chunk consumer. Exceptions it throws abort the transfer.
+     * @return *this
+     */
+    Request& setBodySink(BodySink sink);
+
+    /**
+     * @brief Pauses receiving the response body.
+     * @note Like resume(), call it from the thread running send(), i.e. from the
+     * progress callback (which keeps firing while paused).
+     */
+    void pause();
+
+    /**
+     * @brief Resumes a transfer paused by pause() or by a sink returning SinkAction::Pause.
+     */
+    void resume();
+
+    /**
+     * @brief Supplies the storage the response body is written into.
+     *
+     * The buffer is cleared but keeps its capacity, so passing back the body of a
+     * previous Response avoids reallocating for the next one. Without it, the body
+     * is reserved from Content-Length when the server sends one, up to 4 MiB.
+     * @param buffer Buffer moved into the Request, then into Response::body.
+     * @return *this
+     */
+    Request& setResponseBuffer(std::string buffer);
+
+    /**
+     * @brief Sets a timeout for the request (in seconds).
      * @param seconds Timeout in seconds.
      * @return *this
      */
@@ -461,6 +1359,34 @@ public:
      */
     Request& setConnectTimeout(long seconds);
 
+    /**
+     * @brief Caps the download speed of this transfer.
+     * @param bytesPerSecond Average speed limit, 0 for unlimited.
+     * @return *this
+     */
+    Request& setMaxRecvSpeed(curl_off_t bytesPerSecond);
+
+    /**
+     * @brief Caps the upload speed of this transfer.
+     * @param bytesPerSecond Average speed limit, 0 for unlimited.
+     * @return *this
+     */
+    Request& setMaxSendSpeed(curl_off_t bytesPerSecond);
+
+    /**
+     * @brief Aborts the transfer when it stays slower than a threshold for some time.
+     * @param bytesPerSecond Speed below which the transfer counts as stalled.
+     * @param time How long it may stay stalled; 0 disables the check.
+     * @return *this
+     */
+    Request& setLowSpeedLimit(long bytesPerSecond, std::chrono::seconds time);
+
+    /**
+     * @brief Sets all bandwidth limits at once, replacing pool defaults.
+     * @return *this
+     */
+    Request& setBandwidthLimits(const BandwidthLimits& limits);
+
     /**
      * @brief Enables or disables automatic redirect-following.
      * @param follow True to follow redirects.
@@ -512,19 +1438,101 @@ public:
      * @param enabled True to enable verbose mode.
      * @return *this
      */
-    Request& enableVerbose(bool enabled = true);
+    Request& enableVerbose(bool enabled = true);
+
+    /**
+     * @brief Negotiates compressed responses, decompressed as they are received.
+     *
+     * Offers every content encoding the libcurl build supports (gzip and deflate with
+     * zlib, br with brotli, zstd with zstd); see supportedEncodings().
+     * @param enabled True to send Accept-Encoding.
+     * @return *this
+     */
+    Request& enableCompression(bool enabled = true);
+
+    /**
+     * @brief Applies the socket and protocol settings of a transport profile.
+     *
+     * Like other options it lasts until reset(); pre-connecting is left to the caller.
+     * @param profile Settings to apply, e.g. TransportProfile::lowLatency().
+     * @return *this
+     */
+    Request& setTransportProfile(const TransportProfile& profile);
+
+    /**
+     * @brief Content encodings the linked libcurl can decode, e.g. "gzip, deflate, br".
+     */
+    static std::string supportedEncodings();
+
+    /**
+     * @brief Executes the HTTP request.
+     * @param attempts Tries on transfer errors (not on HTTP statuses), with jittered
+     * exponential backoff from 1s. Use send(RetryPolicy) for finer control.
+     * @return Response object with status, body, headers.
+     * @throws RequestException on failure.
+     */
+    Response send(unsigned attempts = 1);
+
+    /**
+     * @brief Executes the HTTP request, retrying as the policy allows.
+     * @return Response of the last attempt, which may carry a retryable status once
+     * the policy gives up.
+     * @throws RequestException if the last attempt failed at the transfer level.
+     */
+    Response send(const RetryPolicy& policy);
+
+    /**
+     * @brief Resets internal state to allow reuse.
+     *
+     * In handle reuse mode (see setReuseHandle) the easy handle is kept and only
+     * its options are cleared, so its connection, DNS and TLS session caches survive.
+     */
+    void reset();
+
+    /**
+     * @brief Keeps the curl handle, and its caches, across send() and reset().
+     *
+     * send() always resets the request afterwards. By default this creates a new
+     * easy handle, dropping open connections. With reuse enabled only per-request
+     * state (method, URL, body, headers, options) is cleared, so repeated sends to
+     * the same host keep a warm connection.
+     *
+     * @note Cookies received by the handle are kept in memory too.
+     * @param reuse True to reuse the handle.
+     * @return *this
+     */
+    Request& setReuseHandle(bool reuse = true);
+
+    /**
+     * @brief Attaches a cache shared with other Requests (possibly on other threads).
+     *
+     * The cache stays attached across send() and reset().
+     * @param cache Shared cache, or nullptr to detach.
+     * @return *this
+     */
+    Request& setSharedCache(std::shared_ptr<SharedCache> cache);
 
     /**
-     * @brief Executes the HTTP request.
-     * @return Response object with status, body, headers.
-     * @throws RequestException on failure.
+     * @brief Admits every attempt of this request through a rate limiter.
+     *
+     * send() waits for a permit before each attempt; engines keep the request queued
+     * until one is free, without blocking their loop. The limiter stays attached
+     * across send() and reset().
+     * @param limiter Limiter shared with other Requests, or nullptr to detach.
+     * @return *this
      */
-    Response send(unsigned attempts = 1);
+    Request& setRateLimiter(std::shared_ptr<RateLimiter> limiter);
 
     /**
-     * @brief Resets internal state to allow reuse.
+     * @brief Guards this request's endpoint with a circuit breaker.
+     *
+     * While the circuit is open, send() and the engines fail the request with
+     * CircuitOpenException instead of sending it, and send() stops retrying.
+     * The breaker stays attached across send() and reset().
+     * @param breaker Breaker shared with other Requests, or nullptr to detach.
+     * @return *this
      */
-    void reset();
+    Request& setCircuitBreaker(std::shared_ptr<CircuitBreaker> breaker);
 
     /**
      * @brief Set the HTTP protocol version (http1.1, 2 or 3)
@@ -546,6 +1554,9 @@ public:
 
     friend int detail::ProgressCallbackBridge(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
                                           curl_off_t ultotal, curl_off_t ulnow);
+    friend class Engine;
+    friend class SocketEngine;
+    friend class Batch;
 
 
 private:
@@ -555,13 +1566,45 @@ private:
     std::string url, args, body, cookieFile, cookieJar;
     CurlMimePtr mime;
     std::string downloadFilePath;
+    BandwidthLimits bandwidth;
+    bool resumeDownload = false;
+    std::string resumeValidator;
     ProgressCallback progressCallback;
+    BodySink bodySink;
+    std::optional<std::string_view> bodyView; // caller-owned body, see setBodyView
+    std::optional<detail::UploadSource> upload; // streamed body, see setBodySource
+    bool hasBody = false;
+    HeaderMode headerMode = HeaderMode::Parsed;
     HttpVersion httpVersion = HttpVersion::DEFAULT;
+    bool reuseHandle = false;
+    std::shared_ptr<SharedCache> sharedCache;
+    std::shared_ptr<HandlePool> pool;
+    std::shared_ptr<RateLimiter> rateLimiter;
+    std::optional<RateLimiter::Permit> permit; // held from admission to the end of the attempt
+    std::shared_ptr<CircuitBreaker> circuitBreaker;
+
+    // Transfer in flight, kept in the Request so an Engine can drive it too.
+    Response pending;
+    FilePtr fileOut;
+    detail::ResponseBuffer responseBuffer;
+    detail::ResumeTarget resumeTarget;
+    detail::SinkTarget sinkTarget;
+    CurlSlistPtr transferHeaders; // headers plus If-Range while resuming
 
     void clean() noexcept;
     void updateURL();
-    void prepareCurlOptions(Response & response, FilePtr& fileOut, std::ostringstream & responseStream);
+    void prepareCurlOptions();
     void setCurlHttpVersion();
+    bool admit(bool wait);
+    void beginTransfer(bool pausable = true);
+    Response finishTransfer(CURLcode res, unsigned attempt);
+
+    // Transfers on a multi handle, shared by Engine, SocketEngine and Batch.
+    // startOn: admits, prepares and adds the request; false if its rate limiter defers it.
+    // finishOn: removes each finished transfer and passes done(handle, response, error).
+    bool startOn(CURLM* multi, const EngineOptions& options);
+    template <typename Done>
+    static void finishOn(CURLM* multi, Done done);
 };
 
 static_assert(!std::is_copy_constructible_v<Request> && !std::is_copy_assignable_v<Request>,
@@ -579,11 +1622,531 @@ inline int ProgressCallbackBridge(void* clientp, curl_off_t dltotal, curl_off_t
 }
 } // namespace detail
 
+/**
+ * @struct EngineOptions
+ * @brief Connection policy of an Engine or SocketEngine.
+ */
+struct EngineOptions {
+    /// Multiplex concurrent transfers as streams over one HTTP/2 connection per host.
+    /// New transfers wait for that connection (CURLOPT_PIPEWAIT) instead of opening more.
+    bool multiplex = true;
+    long maxConcurrentStreams = 100; ///< Streams per HTTP/2 connection (capped by the server's limit).
+    long maxHostConnections = 0;     ///< Connections per host, 0 for unlimited. Extra transfers queue.
+    long maxTotalConnections = 0;    ///< Connections overall, 0 for unlimited.
+    BandwidthLimits bandwidth;       ///< Defaults for limits a request leaves at 0, enforced per transfer.
+};
+
+namespace detail {
+inline void applyEngineOptions(CURLM* multi, const EngineOptions& options) {
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, options.multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, options.maxConcurrentStreams);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, options.maxHostConnections);
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, options.maxTotalConnections);
+}
+} // namespace detail
+
+/**
+ * @class Engine
+ * @brief Runs many Requests concurrently on one curl_multi event-loop thread.
+ *
+ * Submitted Requests are moved into the engine and performed without blocking
+ * the caller; each completes through a std::future or a callback. Callbacks run
+ * on the engine thread, must not block and should not throw.
+ *
+ * @code
+ * curling::Engine engine;
+ * curling::Request req;
+ * req.setURL("https://example.com");
+ * auto future = engine.submit(std::move(req));
+ * std::cout << future.get().httpCode;
+ * @endcode
+ */
+class Engine {
+public:
+    using Callback = std::function<void(Response response, std::exception_ptr error)>;
+
+    /**
+     * @brief Creates the multi handle and starts the event-loop thread.
+     * @param options Connection policy, HTTP/2 multiplexing by default.
+     * @throws InitializationException if the multi handle cannot be created.
+     */
+    explicit Engine(EngineOptions options = EngineOptions());
+
+    /**
+     * @brief Stops the event loop. Unfinished transfers fail with RequestException.
+     */
+    ~Engine() noexcept;
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    /**
+     * @brief Queues a request.
+     * @param request Configured request, performed once (no retries).
+     * @return Future holding the Response, or the RequestException on failure.
+     */
+    std::future<Response> submit(Request request);
+
+    /**
+     * @brief Queues a request and reports completion to a callback.
+     * @param request Configured request, performed once (no retries).
+     * @param done Called on the engine thread with the response, or a non-null error.
+     */
+    void submit(Request request, Callback done);
+
+    /**
+     * @brief Number of transfers queued or in flight.
+     */
+    std::size_t pending() const noexcept { return inFlight.load(); }
+
+private:
+    struct Job {
+        Request request;
+        Callback done;
+    };
+
+    detail::CurlGlobalGuard curlGlobal;
+    EngineOptions options;
+    CurlMultiPtr multi;
+    std::mutex queueMutex;
+    std::vector<std::unique_ptr<Job>> queued;
+    std::vector<std::unique_ptr<Job>> deferred; // waiting for their rate limiter, engine thread only
+    std::unordered_map<CURL*, std::unique_ptr<Job>> running;
+    std::atomic<std::size_t> inFlight{0};
+    std::atomic<bool> stopping{false};
+    std::thread loop;
+
+    void run();
+    void startQueued();
+    long admissionDelayMs();
+    void completeFinished();
+    void complete(Job& job, Response response, std::exception_ptr error) noexcept;
+};
+
+#ifdef __linux__
+/**
+ * @class SocketEngine
+ * @brief Event-driven engine built on epoll and curl_multi_socket_action.
+ *
+ * Only sockets with activity and expired timers are serviced, so the cost of a
+ * tick does not grow with the number of idle transfers. The engine runs no thread
+ * of its own: either call run(), or add fd() to an existing epoll/poll loop and
+ * call processEvents() whenever it becomes readable (timeoutMs() gives the next
+ * deadline curl asked for; the timer is also reported through fd()).
+ *
+ * @warning Not thread-safe. Submit and process events from the thread driving the loop.
+ */
+class SocketEngine {
+public:
+    using Callback = Engine::Callback;
+
+    /**
+     * @brief Creates the multi handle, the epoll instance and its timer.
+     * @param options Connection policy, HTTP/2 multiplexing by default.
+     * @throws InitializationException if any of them cannot be created.
+     */
+    explicit SocketEngine(EngineOptions options = EngineOptions());
+
+    /**
+     * @brief Unfinished transfers fail with RequestException.
+     */
+    ~SocketEngine() noexcept;
+
+    SocketEngine(const SocketEngine&) = delete;
+    SocketEngine& operator=(const SocketEngine&) = delete;
+
+    /**
+     * @brief Starts a request.
+     * @return Future holding the Response, or the RequestException on failure.
+     * @throws RequestException if the transfer cannot be started.
+     */
+    std::future<Response> submit(Request request);
+
+    /**
+     * @brief Starts a request and reports completion to a callback.
+     * @param done Called from processEvents() with the response, or a non-null error.
+     * @throws RequestException if the transfer cannot be started.
+     */
+    void submit(Request request, Callback done);
+
+    /**
+     * @brief Pollable descriptor, readable when processEvents() has work to do.
+     */
+    int fd() const noexcept { return epollFd; }
+
+    /**
+     * @brief Milliseconds until curl's next timeout, or -1 if none is armed.
+     */
+    long timeoutMs() const noexcept;
+
+    /**
+     * @brief Services ready sockets and expired timers without blocking.
+     */
+    void processEvents();
+
+    /**
+     * @brief Blocks until events arrive or timeout elapses, then processes them.
+     * @param timeoutMs Maximum wait, -1 to wait indefinitely.
+     */
+    void wait(int timeoutMs = -1);
+
+    /**
+     * @brief Drives the loop until every submitted transfer has completed.
+     */
+    void run();
+
+    /**
+     * @brief Number of transfers in flight or waiting for their rate limiter.
+     */
+    std::size_t pending() const noexcept { return running.size() + deferred.size(); }
+
+private:
+    struct Job {
+        Request request;
+        Callback done;
+    };
+
+    detail::CurlGlobalGuard curlGlobal;
+    EngineOptions options;
+    CurlMultiPtr multi;
+    int epollFd = -1;
+    int timerFd = -1;
+    int admitFd = -1; // fires when deferred requests may be admitted
+    std::chrono::steady_clock::time_point deadline;
+    bool timerArmed = false;
+    std::unordered_map<CURL*, std::unique_ptr<Job>> running;
+    std::vector<std::unique_ptr<Job>> deferred; // waiting for their rate limiter
+
+    static int onSocket(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp);
+    static int onTimer(CURLM* multi, long timeoutMs, void* userp);
+    void socketAction(curl_socket_t s, int events);
+    bool start(std::unique_ptr<Job>& job); // false if deferred by its rate limiter
+    void startDeferred();
+    void completeFinished();
+    void closeFds() noexcept;
+};
+
+/**
+ * @struct ParallelDownloadOptions
+ * @brief How downloadParallel() splits a file.
+ */
+struct ParallelDownloadOptions {
+    unsigned connections = 4;           ///< Ranges fetched at once, each on its own connection.
+    curl_off_t minPartSize = 1 << 20;   ///< Files are not split into ranges smaller than this.
+    /// Applied to the probe and to every range request, e.g. to add auth headers.
+    std::function<void(Request&)> configure;
+};
+
+/**
+ * @brief Downloads url to path over several connections at once.
+ *
+ * A HEAD probe reads Content-Length, Accept-Ranges and the validator (ETag or
+ * Last-Modified). If the server takes byte ranges the file is preallocated and
+ * split into ranges fetched concurrently, each written in place with pwrite. Every
+ * range carries If-Range, so a file changing on the server mid-download fails the
+ * download instead of mixing versions. Otherwise it falls back to one stream.
+ * A failed download removes what it wrote to path.
+ * @return Size of the downloaded file, checked against Content-Length.
+ * @throws RequestException on transfer or HTTP errors, or if the server ignores a range.
+ */
+curl_off_t downloadParallel(const std::string& url, const std::string& path,
+                            const ParallelDownloadOptions& options = ParallelDownloadOptions());
+#endif
+
+/**
+ * @struct BatchOptions
+ * @brief How a Batch runs its requests.
+ */
+struct BatchOptions {
+    std::size_t concurrency = 16;  ///< Transfers in flight at once.
+    bool cancelOnFailure = false;  ///< Cancel the rest at the first transfer error (HTTP statuses are not errors).
+    EngineOptions connections;     ///< Multiplexing, connection caps and bandwidth defaults.
+};
+
+/**
+ * @class Batch
+ * @brief Runs many requests concurrently on one curl_multi handle, from the calling thread.
+ *
+ * run() blocks until every request has completed and returns the results in the
+ * order of the input. No threads are created; at most `concurrency` transfers are
+ * in flight. Connections stay open in the Batch between runs. Rate limiters and
+ * circuit breakers attached to the requests are honoured.
+ *
+ * @code
+ * std::vector<curling::Request> requests;
+ * for (const auto& url : urls) {
+ *     requests.emplace_back();
+ *     requests.back().setURL(url);
+ * }
+ * for (auto& result : curling::Batch().run(std::move(requests))) {
+ *     if (result.ok()) std::cout << result.response.httpCode << "\n";
+ * }
+ * @endcode
+ */
+class Batch {
+public:
+    /**
+     * @brief Outcome of one request of the batch.
+     */
+    struct Result {
+        Response response;         ///< Valid when ok().
+        std::exception_ptr error;  ///< Transfer failure, or cancellation (RequestException).
+        bool ok() const noexcept { return !error; }
+    };
+
+    /**
+     * @throws InitializationException if the multi handle cannot be created.
+     */
+    explicit Batch(BatchOptions options = BatchOptions());
+
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    /**
+     * @brief Performs the requests, each once (no retries).
+     * @param requests Configured requests.
+     * @return One result per request, in the same order.
+     */
+    std::vector<Result> run(std::vector<Request> requests);
+
+private:
+    detail::CurlGlobalGuard curlGlobal;
+    BatchOptions options;
+    CurlMultiPtr multi;
+};
+
 } // namespace curling
 
 
 namespace curling {
 
+inline void RateLimiter::Permit::release() noexcept {
+    if (limiter) {
+        limiter->release(host);
+        limiter = nullptr;
+    }
+}
+
+inline RateLimiter::Host& RateLimiter::refill(const std::string& host) {
+    auto now = std::chrono::steady_clock::now();
+    if (hosts.size() >= evictAt) evictIdle(now);
+    auto it = hosts.find(host);
+    if (it == hosts.end()) {
+        return hosts.emplace(host, Host{capacity, now}).first->second;
+    }
+    Host& state = it->second;
+    state.tokens = std::min(capacity, state.tokens + std::chrono::duration<double>(now - state.last).count() * rate);
+    state.last = now;
+    return state;
+}
+
+inline void RateLimiter::evictIdle(std::chrono::steady_clock::time_point now) {
+    // an idle host whose bucket has refilled is no different from one never seen
+    for (auto it = hosts.begin(); it != hosts.end();) {
+        const Host& state = it->second;
+        bool full = rate <= 0 ||
+                    state.tokens + std::chrono::duration<double>(now - state.last).count() * rate >= capacity;
+        if (state.inFlight == 0 && full) {
+            it = hosts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    evictAt = std::max(minEvictionSize, 2 * hosts.size()); // amortized: sweeps grow apart as hosts stay busy
+}
+
+inline std::chrono::milliseconds RateLimiter::delayFor(const Host& state) const {
+    if (maxInFlight > 0 && state.inFlight >= maxInFlight) {
+        return recheckInterval;
+    }
+    if (rate > 0 && state.tokens < 1) {
+        return std::chrono::milliseconds(static_cast<long long>(std::ceil((1 - state.tokens) / rate * 1000)));
+    }
+    return std::chrono::milliseconds(0);
+}
+
+inline std::optional<RateLimiter::Permit> RateLimiter::tryAcquire(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Host& state = refill(host);
+    if (delayFor(state).count() > 0) return std::nullopt;
+    if (rate > 0) state.tokens -= 1;
+    ++state.inFlight;
+    return Permit(this, host);
+}
+
+inline RateLimiter::Permit RateLimiter::acquire(const std::string& host) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        Host& state = refill(host); // map nodes are stable, but refill again after waiting
+        auto delay = delayFor(state);
+        if (delay.count() == 0) {
+            if (rate > 0) state.tokens -= 1;
+            ++state.inFlight;
+            return Permit(this, host);
+        }
+        if (maxInFlight > 0 && state.inFlight >= maxInFlight) {
+            released.wait(lock);
+        } else {
+            released.wait_for(lock, delay);
+        }
+    }
+}
+
+inline std::chrono::milliseconds RateLimiter::admissionDelay(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return delayFor(refill(host));
+}
+
+inline void RateLimiter::release(const std::string& host) noexcept {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = hosts.find(host);
+        if (it != hosts.end() && it->second.inFlight > 0) --it->second.inFlight;
+    }
+    released.notify_all();
+}
+
+inline bool CircuitBreaker::allow(const std::string& endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Endpoint& e = endpoints[endpoint];
+    auto now = std::chrono::steady_clock::now();
+    switch (e.state) {
+        case State::Closed:
+            return true;
+        case State::Open:
+        case State::HalfOpen: // a probe that never reported back is replaced after an interval
+            if (now - e.since < interval) return false;
+            e.state = State::HalfOpen;
+            e.since = now;
+            return true;
+    }
+    return true;
+}
+
+inline void CircuitBreaker::record(const std::string& endpoint, bool success) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Endpoint& e = endpoints[endpoint];
+    if (success) {
+        e.state = State::Closed;
+        e.failures = 0;
+        return;
+    }
+    ++e.failures;
+    if (e.state == State::HalfOpen || e.failures >= threshold) {
+        e.state = State::Open;
+        e.since = std::chrono::steady_clock::now();
+    }
+}
+
+inline CircuitBreaker::State CircuitBreaker::state(const std::string& endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = endpoints.find(endpoint);
+    return it == endpoints.end() ? State::Closed : it->second.state;
+}
+
+inline bool CircuitBreaker::isFailure(CURLcode result, long httpCode) noexcept {
+    switch (result) {
+        case CURLE_OK:
+            return httpCode == 502 || httpCode == 503 || httpCode == 504;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SSL_CONNECT_ERROR:
+            return true;
+        default:
+            return false; // aborted by a callback, bad option, local I/O: not the endpoint's fault
+    }
+}
+
+inline SharedCache::SharedCache(long maxConnections) : poolSize(maxConnections), share(curl_share_init()) {
+    if (!share) {
+        throw InitializationException("Curl share initialization failed");
+    }
+    curl_share_setopt(share.get(), CURLSHOPT_LOCKFUNC, &SharedCache::lock);
+    curl_share_setopt(share.get(), CURLSHOPT_UNLOCKFUNC, &SharedCache::unlock);
+    curl_share_setopt(share.get(), CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share.get(), CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
+inline void SharedCache::lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<SharedCache*>(userptr)->locks[data].lock();
+}
+
+inline void SharedCache::unlock(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<SharedCache*>(userptr)->locks[data].unlock();
+}
+
+inline HandlePool::HandlePool(size_t capacity, std::shared_ptr<SharedCache> cache)
+    : maxIdle(capacity), cache(std::move(cache)) {
+    handles.reserve(maxIdle);
+}
+
+inline void HandlePool::reserve(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (handles.size() < std::min(count, maxIdle)) {
+        CurlPtr handle(curl_easy_init());
+        if (!handle) {
+            throw InitializationException("Curl initialization failed");
+        }
+        handles.push_back(std::move(handle));
+    }
+}
+
+inline CurlPtr HandlePool::acquire() {
+    CurlPtr handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!handles.empty()) {
+            handle = std::move(handles.back());
+            handles.pop_back();
+        }
+    }
+    if (!handle) {
+        handle.reset(curl_easy_init());
+        if (!handle) {
+            throw InitializationException("Curl initialization failed");
+        }
+    }
+    if (cache) {
+        curl_easy_setopt(handle.get(), CURLOPT_SHARE, cache->handle());
+    }
+    return handle;
+}
+
+inline void HandlePool::release(CurlPtr handle) noexcept {
+    if (!handle) return;
+    // Clear options and in-memory cookies; connection, DNS and TLS session caches stay
+    curl_easy_setopt(handle.get(), CURLOPT_COOKIELIST, "ALL");
+    // curl_easy_reset keeps CURLOPT_SHARE: detach now, the Request's cache may go away
+    curl_easy_setopt(handle.get(), CURLOPT_SHARE, nullptr);
+    curl_easy_reset(handle.get());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (handles.size() < maxIdle) {
+        handles.push_back(std::move(handle)); // capacity reserved up front: does not throw
+    }
+}
+
+inline void HandlePool::setBandwidthLimits(const BandwidthLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->limits = limits;
+}
+
+inline BandwidthLimits HandlePool::bandwidthLimits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limits;
+}
+
+inline size_t HandlePool::idle() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return handles.size();
+}
+
 inline Request::Request() : method(Method::GET), curlHandle(nullptr), list(nullptr), cookieFile(""), cookieJar("") {
     detail::ensureCurlGlobalInit();
 
@@ -596,6 +2159,17 @@ inline Request::Request() : method(Method::GET), curlHandle(nullptr), list(nullp
     curl_easy_setopt(curlHandle.get(), CURLOPT_HTTPGET, 1L);
 }
 
+inline Request::Request(std::shared_ptr<HandlePool> pool)
+    : method(Method::GET),
+      curlHandle(pool ? pool->acquire() : throw LogicException("Request constructed from a null HandlePool")),
+      reuseHandle(true), pool(std::move(pool)) {
+    curl_easy_setopt(curlHandle.get(), CURLOPT_HTTPGET, 1L);
+    if (this->pool->sharedCache()) {
+        setSharedCache(this->pool->sharedCache());
+    }
+    bandwidth = this->pool->bandwidthLimits();
+}
+
 inline Request::Request(Request&& other) noexcept
    :method(other.method),
     curlHandle(std::move(other.curlHandle)),
@@ -605,7 +2179,25 @@ inline Request::Request(Request&& other) noexcept
     body(std::move(other.body)),
     cookieFile(std::move(other.cookieFile)),
     cookieJar(std::move(other.cookieJar)),
-    mime(std::move(other.mime)){
+    mime(std::move(other.mime)),
+    downloadFilePath(std::move(other.downloadFilePath)),
+    bandwidth(other.bandwidth),
+    resumeDownload(other.resumeDownload),
+    resumeValidator(std::move(other.resumeValidator)),
+    progressCallback(std::move(other.progressCallback)),
+    bodySink(std::move(other.bodySink)),
+    bodyView(other.bodyView),
+    upload(std::move(other.upload)),
+    hasBody(other.hasBody),
+    headerMode(other.headerMode),
+    httpVersion(other.httpVersion),
+    reuseHandle(other.reuseHandle),
+    sharedCache(std::move(other.sharedCache)),
+    pool(std::move(other.pool)),
+    rateLimiter(std::move(other.rateLimiter)),
+    permit(std::move(other.permit)),
+    circuitBreaker(std::move(other.circuitBreaker)),
+    responseBuffer(std::move(other.responseBuffer)){
 }
 
 inline Request& Request::operator=(Request&& other) noexcept {
@@ -623,13 +2215,30 @@ inline Request& Request::operator=(Request&& other) noexcept {
         body = std::move(other.body);
         cookieFile = std::move(other.cookieFile);
         cookieJar = std::move(other.cookieJar);
+        downloadFilePath = std::move(other.downloadFilePath);
+        bandwidth = other.bandwidth;
+        resumeDownload = other.resumeDownload;
+        resumeValidator = std::move(other.resumeValidator);
+        progressCallback = std::move(other.progressCallback);
+        bodySink = std::move(other.bodySink);
+        bodyView = other.bodyView;
+        upload = std::move(other.upload);
+        hasBody = other.hasBody;
+        headerMode = other.headerMode;
+        httpVersion = other.httpVersion;
+        reuseHandle = other.reuseHandle;
+        sharedCache = std::move(other.sharedCache);
+        pool = std::move(other.pool);
+        rateLimiter = std::move(other.rateLimiter);
+        permit = std::move(other.permit);
+        circuitBreaker = std::move(other.circuitBreaker);
+        responseBuffer = std::move(other.responseBuffer);
     }
     return *this;
 }
 
 inline Request::~Request() noexcept {
     clean();
-    detail::maybeCleanupGlobalCurl();
 }
 
 inline Request& Request::setMethod(Method m) {
@@ -687,112 +2296,263 @@ inline Request& Request::addArg(const std::string& key, const std::string& value
     return *this;
 }
 
+inline Request& Request::setReuseHandle(bool reuse){
+    reuseHandle = reuse;
+    return *this;
+}
+
+inline Request& Request::setRateLimiter(std::shared_ptr<RateLimiter> limiter){
+    rateLimiter = std::move(limiter);
+    return *this;
+}
+
+inline Request& Request::setCircuitBreaker(std::shared_ptr<CircuitBreaker> breaker){
+    circuitBreaker = std::move(breaker);
+    return *this;
+}
+
+inline Request& Request::setSharedCache(std::shared_ptr<SharedCache> cache){
+    curl_easy_setopt(curlHandle.get(), CURLOPT_SHARE, cache ? cache->handle() : nullptr);
+    if (cache) {
+        curl_easy_setopt(curlHandle.get(), CURLOPT_MAXCONNECTS, cache->maxConnections());
+    }
+    sharedCache = std::move(cache);
+    return *this;
+}
+
 inline Request& Request::setProgressCallback(ProgressCallback cb){
     progressCallback = cb;
     return *this;
 }
 
-inline Request& Request::addHeader(const std::string& header) {
-    auto newList = curl_slist_append(list.get(), header.c_str());
-    if(!newList){
-        throw HeaderException("Failed to append header to curl_slist");
+inline Request& Request::addHeader(const std::string& header) {
+    auto newList = curl_slist_append(list.get(), header.c_str());
+    if(!newList){
+        throw HeaderException("Failed to append header to curl_slist");
+    }
+    list.release(); //release is needed here to avoid double free, as newList will contain this old pointer somewhere down the list chain
+    list.reset(newList);
+    curl_easy_setopt(curlHandle.get(), CURLOPT_HTTPHEADER, list.get());
+    return *this;
+}
+
+inline Request& Request::setHeaderMode(HeaderMode mode) {
+    headerMode = mode;
+    return *this;
+}
+
+inline Request& Request::downloadToFile(const std::string& path) {
+    downloadFilePath = path;
+    return *this;
+}
+
+inline Request& Request::setResumeDownload(bool resume, std::string validator) {
+    resumeDownload = resume;
+    resumeValidator = std::move(validator);
+    return *this;
+}
+
+inline Request& Request::setBodySink(BodySink sink) {
+    bodySink = std::move(sink);
+    return *this;
+}
+
+inline void Request::pause() {
+    curl_easy_pause(curlHandle.get(), CURLPAUSE_RECV);
+}
+
+inline void Request::resume() {
+    curl_easy_pause(curlHandle.get(), CURLPAUSE_CONT);
+}
+
+inline Request& Request::setResponseBuffer(std::string buffer) {
+    responseBuffer.data = std::move(buffer);
+    return *this;
+}
+
+inline Request& Request::setBody(const std::string& body) {
+    this->body = body;
+    bodyView.reset();
+    upload.reset();
+    hasBody = true;
+    return *this;
+}
+
+inline Request& Request::setBody(std::string&& body) {
+    this->body = std::move(body);
+    bodyView.reset();
+    upload.reset();
+    hasBody = true;
+    return *this;
+}
+
+inline Request& Request::setBodyView(std::string_view body) {
+    this->body.clear();
+    bodyView = body;
+    upload.reset();
+    hasBody = true;
+    return *this;
+}
+
+inline Request& Request::setBodySource(BodySource source, curl_off_t length) {
+    body.clear();
+    bodyView.reset();
+    upload = detail::UploadSource{std::move(source), nullptr, length};
+    hasBody = true;
+    return *this;
+}
+
+inline Request& Request::setBodyFile(const std::string& path) {
+    std::shared_ptr<FILE> file(std::fopen(path.c_str(), "rb"), FileCloser{});
+    if (!file) {
+        throw RequestException("Failed to open file for reading: " + path);
     }
-    list.release(); //release is needed here to avoid double free, as newList will contain this old pointer somewhere down the list chain
-    list.reset(newList);
-    curl_easy_setopt(curlHandle.get(), CURLOPT_HTTPHEADER, list.get());
-    return *this;
-}
+    struct stat info;
+    if (fstat(fileno(file.get()), &info) != 0) {
+        throw RequestException("Failed to read the size of file: " + path);
+    }
+    bool regular = S_ISREG(info.st_mode);
 
-inline Request& Request::downloadToFile(const std::string& path) {
-    downloadFilePath = path;
+    setBodySource([file](char* buffer, size_t size) {
+        size_t read = std::fread(buffer, 1, size, file.get());
+        if (read == 0 && std::ferror(file.get())) {
+            throw RequestException("Failed to read upload file"); // aborts the transfer
+        }
+        return read;
+    }, regular ? static_cast<curl_off_t>(info.st_size) : -1);
+    if (regular) {
+        upload->seek = [file](curl_off_t offset) {
+            return fseeko(file.get(), static_cast<off_t>(offset), SEEK_SET) == 0;
+        };
+    }
     return *this;
 }
 
-inline Request& Request::setBody(const std::string& body) {
-    this->body = body;
-    if (method == Method::POST || method == Method::PUT || method == Method::PATCH) {
-        curl_easy_setopt(curlHandle.get(), CURLOPT_COPYPOSTFIELDS, this->body.c_str());
+inline Request& Request::setBodyStream(std::istream& in, curl_off_t length) {
+    auto* stream = &in;
+    setBodySource([stream](char* buffer, size_t size) {
+        stream->read(buffer, static_cast<std::streamsize>(size));
+        return static_cast<size_t>(stream->gcount());
+    }, length);
+
+    std::streampos start = in.tellg();
+    if (start != std::streampos(-1)) {
+        upload->seek = [stream, start](curl_off_t offset) {
+            stream->clear();
+            return static_cast<bool>(stream->seekg(start + static_cast<std::streamoff>(offset)));
+        };
     }
     return *this;
 }
 
 inline Response Request::send(unsigned attempts) {
-    if (attempts == 0) {
+    RetryPolicy policy;
+    policy.maxAttempts = attempts;
+    policy.baseDelay = std::chrono::milliseconds(1000); // initial delay of 1 second
+    policy.maxDelay = std::chrono::hours(1);
+    policy.retryStatuses.clear();
+    policy.retryNonIdempotent = true;
+    policy.budget = nullptr;
+    return send(policy);
+}
+
+inline Response Request::send(const RetryPolicy& policy) {
+    if (policy.maxAttempts == 0) {
         throw LogicException("Number of attempts must be greater than zero");
     }
 
-    const unsigned baseDelayMs = 1000; // initial delay of 1 second
-
-    Response response;
-    FilePtr fileOut(nullptr);
-    std::ostringstream responseStream;
-
-        
-    prepareCurlOptions(response, fileOut, responseStream);
-    updateURL();
-    setCurlHttpVersion();
+    const auto start = std::chrono::steady_clock::now();
+    const bool idempotent = method != Method::POST && method != Method::PATCH && method != Method::MIME;
 
-    for (unsigned attempt = 1; attempt <= attempts; ++attempt) {
-        
-        try{
-            // Perform request
-            CURLcode res = curl_easy_perform(curlHandle.get());
-
-            // Get HTTP status code regardless of result
-            curl_easy_getinfo(curlHandle.get(), CURLINFO_RESPONSE_CODE, &(response.httpCode));
+    for (unsigned attempt = 1; ; ++attempt) {
+        beginTransfer(); // also clears what a failed attempt received
+        try {
+            admit(true);
+        } catch (...) {
+            reset(); // as after a failed attempt
+            throw;
+        }
 
-            if (res != CURLE_OK) {
-                throw RequestException(
-                    std::string("Curl perform failed on attempt ") + std::to_string(attempt) +
-                    ": " + curl_easy_strerror(res)
-                );
-            }
+        // Perform request
+        CURLcode res = curl_easy_perform(curlHandle.get());
+
+        Response response;
+        std::exception_ptr failure;
+        bool retryable = false;
+        try {
+            response = finishTransfer(res, attempt);
+            retryable = policy.isRetryStatus(response.httpCode) &&
+                        (idempotent || policy.retryNonIdempotent || response.httpCode == 429);
+        } catch (const RequestException&) {
+            failure = std::current_exception();
+            bool notSent = res == CURLE_COULDNT_RESOLVE_HOST || res == CURLE_COULDNT_RESOLVE_PROXY ||
+                           res == CURLE_COULDNT_CONNECT;
+            retryable = idempotent || policy.retryNonIdempotent || notSent;
+        }
 
-            // Store response body if not downloading to file
-            if (downloadFilePath.empty()) {
-                response.body = responseStream.str();
+        std::chrono::milliseconds delay{0};
+        if (retryable && attempt < policy.maxAttempts) {
+            curl_off_t retryAfter = 0; // seconds, parsed by libcurl from Retry-After
+            curl_easy_getinfo(curlHandle.get(), CURLINFO_RETRY_AFTER, &retryAfter);
+            delay = policy.delayFor(attempt, std::chrono::seconds(retryAfter));
+            if (std::chrono::seconds(retryAfter) > policy.maxDelay) {
+                retryable = false; // retrying sooner than the server asked would only be refused again
+            } else if (policy.deadline.count() > 0 && std::chrono::steady_clock::now() + delay > start + policy.deadline) {
+                retryable = false;
+            } else if (circuitBreaker && circuitBreaker->state(detail::hostKey(url)) == CircuitBreaker::State::Open) {
+                retryable = false; // the breaker just opened: report this failure, not the open circuit
+            } else if (upload && !(upload->seek && upload->seek(0))) {
+                retryable = false; // a streamed body that cannot be rewound is sent once
+            } else if (sinkTarget.received) {
+                retryable = false; // the sink holds this response's body, a retry would append another
+            } else if (policy.budget && !policy.budget->tryAcquire()) {
+                retryable = false;
             }
+        }
 
+        if (!retryable || attempt >= policy.maxAttempts) {
             reset(); // Reset for reuse
+            if (failure) std::rethrow_exception(failure);
             return response;
-
-        } catch (const RequestException& e) {
-            if (attempt == attempts) {
-                reset();
-                throw; // rethrow if final attempt fails
-            }
-
-            // Calculate exponential backoff delay
-            unsigned delayMs = baseDelayMs * (1 << (attempt - 1));
-
-            // Optional: Add jitter (randomize slightly to avoid thundering herd)
-            // delayMs += rand() % 250;
-
-            std::cerr << "Retry attempt " << attempt << " failed. Retrying in " << delayMs << "ms...\n";
-
-            waitMs(delayMs);
         }
-    }
 
-    // Should never be reached
-    throw LogicException("Retry logic terminated unexpectedly");
+        std::this_thread::sleep_for(delay);
+    }
 }
 
 inline void Request::reset() {
-    // Create and immediately assign new handle
-    curlHandle.reset(curl_easy_init());
-    if (!curlHandle) {
-        throw InitializationException("Curl re-initialization failed");
+    if ((reuseHandle || pool) && curlHandle) {
+        // Clears options only; live connections, DNS and TLS session caches are kept
+        curl_easy_reset(curlHandle.get());
+    } else {
+        // Create and immediately assign new handle
+        curlHandle.reset(curl_easy_init());
+        if (!curlHandle) {
+            throw InitializationException("Curl re-initialization failed");
+        }
     }
 
     mime.reset();
     list.reset();
+    transferHeaders.reset();
+    fileOut.reset();
+    permit.reset();
+    responseBuffer = detail::ResponseBuffer{};
+    pending = Response{};
 
     args.clear();
     url.clear();
     body.clear();
+    bodyView.reset();
+    upload.reset();
+    hasBody = false;
+    headerMode = HeaderMode::Parsed;
     downloadFilePath.clear();
+    bandwidth = pool ? pool->bandwidthLimits() : BandwidthLimits{};
+    resumeDownload = false;
+    resumeValidator.clear();
     progressCallback = nullptr;
+    bodySink = nullptr;
     cookieFile.clear();
     cookieJar.clear();
 
@@ -801,11 +2561,20 @@ inline void Request::reset() {
 
     httpVersion = HttpVersion::DEFAULT;
     curl_easy_setopt(curlHandle.get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_NONE);
+
+    if (sharedCache) {
+        curl_easy_setopt(curlHandle.get(), CURLOPT_SHARE, sharedCache->handle());
+        curl_easy_setopt(curlHandle.get(), CURLOPT_MAXCONNECTS, sharedCache->maxConnections());
+    }
 }
 
 inline void Request::clean() noexcept {
+    permit.reset();
     mime.reset();
     list.reset();
+    if (pool) {
+        pool->release(std::move(curlHandle));
+    }
     curlHandle.reset();
 }
 
@@ -814,6 +2583,17 @@ inline void Request::updateURL() {
     curl_easy_setopt(curlHandle.get(), CURLOPT_URL, s.c_str());
 }
 
+inline Request& Request::setRange(curl_off_t first, curl_off_t last){
+    std::string range = std::to_string(first) + "-" + (last >= 0 ? std::to_string(last) : std::string());
+    curl_easy_setopt(curlHandle.get(), CURLOPT_RANGE, range.c_str()); // libcurl copies the string
+    return *this;
+}
+
+inline Request& Request::setUnixSocketPath(const std::string& path){
+    curl_easy_setopt(curlHandle.get(), CURLOPT_UNIX_SOCKET_PATH, path.c_str());
+    return *this;
+}
+
 inline Request& Request::setTimeout(long seconds){
     curl_easy_setopt(curlHandle.get(), CURLOPT_TIMEOUT, seconds);
     return *this;
@@ -851,6 +2631,27 @@ inline Request& Request::setConnectTimeout(long seconds){
     return *this;
 }
 
+inline Request& Request::setMaxRecvSpeed(curl_off_t bytesPerSecond){
+    bandwidth.maxRecvBytesPerSecond = bytesPerSecond;
+    return *this;
+}
+
+inline Request& Request::setMaxSendSpeed(curl_off_t bytesPerSecond){
+    bandwidth.maxSendBytesPerSecond = bytesPerSecond;
+    return *this;
+}
+
+inline Request& Request::setLowSpeedLimit(long bytesPerSecond, std::chrono::seconds time){
+    bandwidth.lowSpeedBytesPerSecond = bytesPerSecond;
+    bandwidth.lowSpeedTime = time;
+    return *this;
+}
+
+inline Request& Request::setBandwidthLimits(const BandwidthLimits& limits){
+    bandwidth = limits;
+    return *this;
+}
+
 inline Request& Request::setAuthToken(const std::string& token){
     std::string header = "Authorization: Bearer " + token;
     addHeader(header);
@@ -904,6 +2705,42 @@ inline Request& Request::addFormFile(const std::string& fieldName, const std::st
     return *this;
 }
 
+inline Request& Request::enableCompression(bool enabled){
+    // an empty string lets libcurl offer all the encodings it was built with
+    curl_easy_setopt(curlHandle.get(), CURLOPT_ACCEPT_ENCODING, enabled ? "" : nullptr);
+    return *this;
+}
+
+inline Request& Request::setTransportProfile(const TransportProfile& profile){
+    CURL* handle = curlHandle.get();
+    curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, profile.tcpNoDelay ? 1L : 0L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, profile.tcpKeepAlive ? 1L : 0L);
+    if (profile.tcpKeepAlive) {
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, static_cast<long>(profile.keepAliveIdle.count()));
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, static_cast<long>(profile.keepAliveInterval.count()));
+    }
+    if (profile.receiveBufferSize > 0) {
+        curl_easy_setopt(handle, CURLOPT_BUFFERSIZE, profile.receiveBufferSize);
+    }
+    if (profile.uploadBufferSize > 0) {
+        curl_easy_setopt(handle, CURLOPT_UPLOAD_BUFFERSIZE, profile.uploadBufferSize);
+    }
+    if (!profile.expectContinue) {
+        addHeader("Expect:"); // an empty value removes the header libcurl would add
+    }
+    return *this;
+}
+
+inline std::string Request::supportedEncodings(){
+    curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+    std::string encodings;
+    auto add = [&](const char* name) { encodings.append(encodings.empty() ? "" : ", ").append(name); };
+    if (info->features & CURL_VERSION_LIBZ) { add("gzip"); add("deflate"); }
+    if (info->features & CURL_VERSION_BROTLI) add("br");
+    if (info->features & CURL_VERSION_ZSTD) add("zstd");
+    return encodings;
+}
+
 inline Request& Request::enableVerbose(bool enabled){
     curl_easy_setopt(curlHandle.get(), CURLOPT_VERBOSE, enabled ? 1L : 0L);
     return *this;
@@ -916,6 +2753,7 @@ inline Request& Request::setHttpVersion(HttpVersion version) {
 
     switch (version) {
         case HttpVersion::HTTP_2:
+        case HttpVersion::HTTP_2_PRIOR_KNOWLEDGE:
             if (!(info->features & CURL_VERSION_HTTP2)) {
                 throw LogicException("HTTP/2 is not supported by the current libcurl build.");
             }
@@ -933,7 +2771,145 @@ inline Request& Request::setHttpVersion(HttpVersion version) {
     return *this;
 }
 
-inline void Request::prepareCurlOptions(Response& response, FilePtr& fileOut, std::ostringstream& responseStream) {
+inline void Request::beginTransfer(bool pausable) {
+    if (resumeDownload) {
+        // what the previous attempt left on disk came with this validator
+        std::string validator = detail::ifRangeValidator(pending);
+        if (!validator.empty()) resumeValidator = std::move(validator);
+    }
+    pending = Response{};
+    responseBuffer.data.clear(); // keeps the capacity of a buffer given to setResponseBuffer
+    responseBuffer.handle = curlHandle.get();
+    responseBuffer.sized = false;
+    sinkTarget = detail::SinkTarget{&bodySink, pausable, false, false};
+    prepareCurlOptions();
+    updateURL();
+    setCurlHttpVersion();
+}
+
+inline bool Request::admit(bool wait) {
+    if (!rateLimiter && !circuitBreaker) return true;
+    std::string host = detail::hostKey(url);
+    if (rateLimiter && !permit) {
+        if (wait) {
+            permit.emplace(rateLimiter->acquire(host));
+        } else if (auto granted = rateLimiter->tryAcquire(host)) {
+            permit.emplace(std::move(*granted));
+        } else {
+            return false;
+        }
+    }
+    // checked last so a deferred request does not take a half-open circuit's probe slot
+    if (circuitBreaker && !circuitBreaker->allow(host)) {
+        permit.reset();
+        throw CircuitOpenException("Circuit open for " + host + ": endpoint failing, request not sent");
+    }
+    return true;
+}
+
+inline Response Request::finishTransfer(CURLcode res, unsigned attempt) {
+    permit.reset(); // the attempt is over: free its in-flight slot
+
+    // Get HTTP status code regardless of result
+    curl_easy_getinfo(curlHandle.get(), CURLINFO_RESPONSE_CODE, &(pending.httpCode));
+    pending.info = detail::readTransferInfo(curlHandle.get());
+
+    if (circuitBreaker) {
+        circuitBreaker->record(detail::hostKey(url), !CircuitBreaker::isFailure(res, pending.httpCode));
+    }
+
+    if (res != CURLE_OK && sinkTarget.pauseRefused) {
+        throw LogicException("Body sink returned SinkAction::Pause, which only send() can resume");
+    }
+    if (res != CURLE_OK) {
+        throw RequestException(
+            std::string("Curl perform failed on attempt ") + std::to_string(attempt) +
+            ": " + curl_easy_strerror(res)
+        );
+    }
+
+    if (resumeDownload && !downloadFilePath.empty() && resumeTarget.offset > 0 && pending.httpCode == 416 &&
+        detail::unsatisfiedRangeLength(pending) == resumeTarget.offset) {
+        pending.httpCode = 200; // nothing past the end of the file: it is already complete
+    }
+
+    // Store response body if not downloading to file or streaming to a sink
+    if (downloadFilePath.empty() && !bodySink) {
+        pending.body = std::move(responseBuffer.data);
+    }
+    fileOut.reset(); // flush and close the download, if any
+    return std::move(pending);
+}
+
+inline bool Request::startOn(CURLM* multi, const EngineOptions& options) {
+    if (!admit(false)) return false;
+    try {
+        bandwidth = bandwidth.orDefaults(options.bandwidth);
+        beginTransfer(false); // moved into the engine: nobody could resume a paused transfer
+        CURL* handle = curlHandle.get();
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, options.multiplex ? 1L : 0L);
+        curl_easy_setopt(handle, CURLOPT_PRIVATE, this); // found again by finishOn
+        if (curl_multi_add_handle(multi, handle) != CURLM_OK) {
+            throw RequestException("Failed to add request to the multi handle");
+        }
+    } catch (...) {
+        permit.reset(); // never started: free the in-flight slot now
+        throw;
+    }
+    return true;
+}
+
+template <typename Done>
+inline void Request::finishOn(CURLM* multi, Done done) {
+    int remaining = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi, &remaining)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        CURL* handle = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        curl_multi_remove_handle(multi, handle);
+
+        char* owner = nullptr;
+        curl_easy_getinfo(handle, CURLINFO_PRIVATE, &owner);
+        Response response;
+        std::exception_ptr error;
+        try {
+            response = reinterpret_cast<Request*>(owner)->finishTransfer(result, 1);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done(handle, std::move(response), error);
+    }
+}
+
+inline void Request::prepareCurlOptions() {
+    // Point libcurl at the body in place; it is set here, once the Request no longer moves
+    bool sendsBody = hasBody && (method == Method::POST || method == Method::PUT || method == Method::PATCH);
+    if (sendsBody && upload) {
+        curl_easy_setopt(curlHandle.get(), CURLOPT_READFUNCTION, detail::ReadCallback);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_READDATA, &*upload);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_SEEKFUNCTION, detail::SeekCallback);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_SEEKDATA, &*upload);
+        if (method == Method::PUT) {
+            curl_easy_setopt(curlHandle.get(), CURLOPT_UPLOAD, 1L);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_INFILESIZE_LARGE, upload->length);
+        } else {
+            // POST semantics with a read callback; CUSTOMREQUEST still names PATCH
+            curl_easy_setopt(curlHandle.get(), CURLOPT_POST, 1L);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_POSTFIELDS, nullptr);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_POSTFIELDSIZE_LARGE, upload->length);
+        }
+    } else if (sendsBody) {
+        std::string_view data = bodyView ? *bodyView : std::string_view(body);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(data.size()));
+        curl_easy_setopt(curlHandle.get(), CURLOPT_POSTFIELDS, data.data());
+    }
+
+    curl_easy_setopt(curlHandle.get(), CURLOPT_MAX_RECV_SPEED_LARGE, bandwidth.maxRecvBytesPerSecond);
+    curl_easy_setopt(curlHandle.get(), CURLOPT_MAX_SEND_SPEED_LARGE, bandwidth.maxSendBytesPerSecond);
+    curl_easy_setopt(curlHandle.get(), CURLOPT_LOW_SPEED_LIMIT, bandwidth.lowSpeedBytesPerSecond);
+    curl_easy_setopt(curlHandle.get(), CURLOPT_LOW_SPEED_TIME, static_cast<long>(bandwidth.lowSpeedTime.count()));
+
     // Set progress callback if defined
     if (progressCallback) {
         curl_easy_setopt(curlHandle.get(), CURLOPT_XFERINFOFUNCTION, detail::ProgressCallbackBridge);
@@ -943,22 +2919,71 @@ inline void Request::prepareCurlOptions(Response& response, FilePtr& fileOut, st
         curl_easy_setopt(curlHandle.get(), CURLOPT_NOPROGRESS, 1L);
     }
 
-    // Set output destination (file or memory stream)
-    if (!downloadFilePath.empty()) {
+    // Set output destination (file, sink or memory buffer)
+    if (!downloadFilePath.empty() && resumeDownload) {
+        fileOut.reset(std::fopen(downloadFilePath.c_str(), "ab")); // never truncates
+        if (!fileOut) {
+            throw RequestException("Failed to open file for writing: " + downloadFilePath);
+        }
+        std::error_code ec;
+        auto size = std::filesystem::file_size(downloadFilePath, ec);
+        resumeTarget = detail::ResumeTarget{fileOut.get(), curlHandle.get(), downloadFilePath,
+                                            ec ? 0 : static_cast<curl_off_t>(size)};
+
+        transferHeaders.reset();
+        if (resumeTarget.offset > 0) {
+            std::string range = std::to_string(resumeTarget.offset) + "-";
+            curl_easy_setopt(curlHandle.get(), CURLOPT_RANGE, range.c_str());
+            if (!resumeValidator.empty()) {
+                auto append = [this](const std::string& header) {
+                    auto newList = curl_slist_append(transferHeaders.get(), header.c_str());
+                    if (!newList) {
+                        throw HeaderException("Failed to append header to curl_slist");
+                    }
+                    transferHeaders.release(); // newList still holds the old nodes
+                    transferHeaders.reset(newList);
+                };
+                for (curl_slist* item = list.get(); item; item = item->next) {
+                    append(item->data);
+                }
+                append("If-Range: " + resumeValidator);
+            }
+        } else {
+            curl_easy_setopt(curlHandle.get(), CURLOPT_RANGE, nullptr);
+        }
+        curl_easy_setopt(curlHandle.get(), CURLOPT_HTTPHEADER, transferHeaders ? transferHeaders.get() : list.get());
+        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEFUNCTION, detail::ResumeWriteCallback);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEDATA, &resumeTarget);
+    } else if (!downloadFilePath.empty()) {
         fileOut.reset(std::fopen(downloadFilePath.c_str(), "wb"));
         if (!fileOut) {
             throw RequestException("Failed to open file for writing: " + downloadFilePath);
         }
         curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEFUNCTION, nullptr);
         curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEDATA, fileOut.get());
+    } else if (bodySink) {
+        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEFUNCTION, detail::SinkCallback);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEDATA, &sinkTarget);
     } else {
         curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEFUNCTION, detail::WriteCallback);
-        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEDATA, &responseStream);
+        curl_easy_setopt(curlHandle.get(), CURLOPT_WRITEDATA, &responseBuffer);
     }
 
     // Set header callback
-    curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERFUNCTION, detail::HeaderCallback);
-    curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERDATA, &(response.headers));
+    switch (headerMode) {
+        case HeaderMode::Parsed:
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERFUNCTION, detail::HeaderCallback);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERDATA, &(pending.headers));
+            break;
+        case HeaderMode::Raw:
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERFUNCTION, detail::RawHeaderCallback);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERDATA, &(pending.rawHeaders));
+            break;
+        case HeaderMode::None:
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERFUNCTION, detail::DiscardCallback);
+            curl_easy_setopt(curlHandle.get(), CURLOPT_HEADERDATA, nullptr);
+            break;
+    }
 }
 
 inline void Request::setCurlHttpVersion() {
@@ -967,10 +2992,565 @@ inline void Request::setCurlHttpVersion() {
         case HttpVersion::HTTP_1_1: curl_http_version = CURL_HTTP_VERSION_1_1; break;
         case HttpVersion::HTTP_2:   curl_http_version = CURL_HTTP_VERSION_2_0; break;
         case HttpVersion::HTTP_3:   curl_http_version = CURL_HTTP_VERSION_3;   break;
+        case HttpVersion::HTTP_2_PRIOR_KNOWLEDGE: curl_http_version = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE; break;
         case HttpVersion::DEFAULT:
         default:                    curl_http_version = CURL_HTTP_VERSION_NONE; break;
     }
     curl_easy_setopt(curlHandle.get(), CURLOPT_HTTP_VERSION, curl_http_version);
 }
 
+inline Engine::Engine(EngineOptions options) : options(options), multi(curl_multi_init()) {
+    if (!multi) {
+        throw InitializationException("Curl multi initialization failed");
+    }
+    detail::applyEngineOptions(multi.get(), options);
+    loop = std::thread(&Engine::run, this);
+}
+
+inline Engine::~Engine() noexcept {
+    stopping = true;
+    curl_multi_wakeup(multi.get());
+    if (loop.joinable()) loop.join();
+}
+
+inline std::future<Response> Engine::submit(Request request) {
+    auto promise = std::make_shared<std::promise<Response>>();
+    auto future = promise->get_future();
+    submit(std::move(request), [promise](Response response, std::exception_ptr error) {
+        if (error) promise->set_exception(error);
+        else promise->set_value(std::move(response));
+    });
+    return future;
+}
+
+inline void Engine::submit(Request request, Callback done) {
+    auto job = std::unique_ptr<Job>(new Job{std::move(request), std::move(done)});
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queued.push_back(std::move(job));
+    }
+    ++inFlight;
+    curl_multi_wakeup(multi.get());
+}
+
+inline void Engine::run() {
+    while (!stopping) {
+        startQueued();
+
+        int stillRunning = 0;
+        curl_multi_perform(multi.get(), &stillRunning);
+        completeFinished();
+
+        curl_multi_poll(multi.get(), nullptr, 0, deferred.empty() ? 1000 : admissionDelayMs(), nullptr);
+    }
+
+    // Fail whatever did not get to finish
+    for (auto& entry : running) {
+        curl_multi_remove_handle(multi.get(), entry.first);
+        complete(*entry.second, Response{}, std::make_exception_ptr(RequestException("Engine stopped")));
+    }
+    running.clear();
+    for (auto& job : deferred) {
+        complete(*job, Response{}, std::make_exception_ptr(RequestException("Engine stopped")));
+    }
+    deferred.clear();
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto& job : queued) {
+        complete(*job, Response{}, std::make_exception_ptr(RequestException("Engine stopped")));
+    }
+    queued.clear();
+}
+
+inline void Engine::startQueued() {
+    std::vector<std::unique_ptr<Job>> batch;
+    batch.swap(deferred);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        std::move(queued.begin(), queued.end(), std::back_inserter(batch));
+        queued.clear();
+    }
+    for (auto& job : batch) {
+        try {
+            if (!job->request.startOn(multi.get(), options)) {
+                deferred.push_back(std::move(job));
+                continue;
+            }
+            CURL* handle = job->request.curlHandle.get();
+            running.emplace(handle, std::move(job));
+        } catch (...) {
+            complete(*job, Response{}, std::current_exception());
+        }
+    }
+}
+
+inline long Engine::admissionDelayMs() {
+    long delay = 1000;
+    for (auto& job : deferred) {
+        auto wait = job->request.rateLimiter->admissionDelay(RateLimiter::hostOf(job->request.url));
+        delay = std::min(delay, std::max(1L, static_cast<long>(wait.count())));
+    }
+    return delay;
+}
+
+inline void Engine::completeFinished() {
+    Request::finishOn(multi.get(), [this](CURL* handle, Response response, std::exception_ptr error) {
+        auto it = running.find(handle);
+        if (it == running.end()) return;
+        std::unique_ptr<Job> job = std::move(it->second);
+        running.erase(it);
+        complete(*job, std::move(response), error);
+    });
+}
+
+inline void Engine::complete(Job& job, Response response, std::exception_ptr error) noexcept {
+    try {
+        if (job.done) job.done(std::move(response), error);
+    } catch (...) {
+        // a throwing callback must not take the event loop down
+    }
+    --inFlight;
+}
+
+#ifdef __linux__
+inline SocketEngine::SocketEngine(EngineOptions options) : options(options), multi(curl_multi_init()) {
+    if (!multi) {
+        throw InitializationException("Curl multi initialization failed");
+    }
+    detail::applyEngineOptions(multi.get(), options);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    admitFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd < 0 || timerFd < 0 || admitFd < 0) {
+        closeFds();
+        throw InitializationException("Failed to create epoll instance or timer");
+    }
+    for (int fd : {timerFd, admitFd}) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            closeFds();
+            throw InitializationException("Failed to register timer with epoll");
+        }
+    }
+
+    curl_multi_setopt(multi.get(), CURLMOPT_SOCKETFUNCTION, &SocketEngine::onSocket);
+    curl_multi_setopt(multi.get(), CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi.get(), CURLMOPT_TIMERFUNCTION, &SocketEngine::onTimer);
+    curl_multi_setopt(multi.get(), CURLMOPT_TIMERDATA, this);
+}
+
+inline SocketEngine::~SocketEngine() noexcept {
+    for (auto& entry : running) {
+        curl_multi_remove_handle(multi.get(), entry.first);
+        try {
+            if (entry.second->done) {
+                entry.second->done(Response{}, std::make_exception_ptr(RequestException("Engine stopped")));
+            }
+        } catch (...) {
+        }
+    }
+    running.clear();
+    for (auto& job : deferred) {
+        try {
+            if (job->done) job->done(Response{}, std::make_exception_ptr(RequestException("Engine stopped")));
+        } catch (...) {
+        }
+    }
+    deferred.clear();
+    multi.reset(); // closes remaining sockets through onSocket before the fds go away
+    closeFds();
+}
+
+inline void SocketEngine::closeFds() noexcept {
+    if (admitFd >= 0) ::close(admitFd);
+    if (timerFd >= 0) ::close(timerFd);
+    if (epollFd >= 0) ::close(epollFd);
+    admitFd = timerFd = epollFd = -1;
+}
+
+inline std::future<Response> SocketEngine::submit(Request request) {
+    auto promise = std::make_shared<std::promise<Response>>();
+    auto future = promise->get_future();
+    submit(std::move(request), [promise](Response response, std::exception_ptr error) {
+        if (error) promise->set_exception(error);
+        else promise->set_value(std::move(response));
+    });
+    return future;
+}
+
+inline void SocketEngine::submit(Request request, Callback done) {
+    auto job = std::unique_ptr<Job>(new Job{std::move(request), std::move(done)});
+    if (!start(job)) {
+        deferred.push_back(std::move(job));
+        startDeferred(); // arms the admission timer
+    }
+}
+
+inline bool SocketEngine::start(std::unique_ptr<Job>& job) {
+    if (!job->request.startOn(multi.get(), options)) return false;
+    CURL* handle = job->request.curlHandle.get();
+    running.emplace(handle, std::move(job));
+    return true;
+}
+
+inline void SocketEngine::startDeferred() {
+    std::vector<std::unique_ptr<Job>> batch;
+    batch.swap(deferred);
+    long delay = -1;
+    for (auto& job : batch) {
+        try {
+            if (start(job)) continue;
+            auto wait = job->request.rateLimiter->admissionDelay(RateLimiter::hostOf(job->request.url));
+            long ms = std::max(1L, static_cast<long>(wait.count()));
+            delay = delay < 0 ? ms : std::min(delay, ms);
+            deferred.push_back(std::move(job));
+        } catch (...) {
+            try {
+                if (job->done) job->done(Response{}, std::current_exception());
+            } catch (...) {
+            }
+        }
+    }
+
+    itimerspec spec{};
+    if (delay > 0) {
+        spec.it_value.tv_sec = delay / 1000;
+        spec.it_value.tv_nsec = delay % 1000 * 1000000L;
+    }
+    timerfd_settime(admitFd, 0, &spec, nullptr);
+}
+
+inline long SocketEngine::timeoutMs() const noexcept {
+    if (!timerArmed) return -1;
+    // rounded up: a deadline 0.4ms away is not due yet, and reporting 0 would spin the caller
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return left.count() > 0 ? static_cast<long>(left.count()) : 0;
+}
+
+inline int SocketEngine::onSocket(CURL*, curl_socket_t s, int what, void* userp, void* socketp) {
+    auto* self = static_cast<SocketEngine*>(userp);
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(self->epollFd, EPOLL_CTL_DEL, s, nullptr); // may already be closed
+        return 0;
+    }
+
+    epoll_event ev{};
+    ev.data.fd = s;
+    if (what & CURL_POLL_IN) ev.events |= EPOLLIN;
+    if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+
+    if (socketp) {
+        epoll_ctl(self->epollFd, EPOLL_CTL_MOD, s, &ev);
+    } else {
+        epoll_ctl(self->epollFd, EPOLL_CTL_ADD, s, &ev);
+        curl_multi_assign(self->multi.get(), s, self); // marks the socket as registered
+    }
+    return 0;
+}
+
+inline int SocketEngine::onTimer(CURLM*, long timeoutMs, void* userp) {
+    auto* self = static_cast<SocketEngine*>(userp);
+    itimerspec spec{};
+    if (timeoutMs < 0) {
+        self->timerArmed = false;
+    } else {
+        self->timerArmed = true;
+        self->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        // a zero it_value disarms the timer, so "now" is expressed as 1ns
+        spec.it_value.tv_sec = timeoutMs / 1000;
+        spec.it_value.tv_nsec = timeoutMs % 1000 * 1000000L + (timeoutMs == 0 ? 1 : 0);
+    }
+    timerfd_settime(self->timerFd, 0, &spec, nullptr);
+    return 0;
+}
+
+inline void SocketEngine::socketAction(curl_socket_t s, int events) {
+    int stillRunning = 0;
+    curl_multi_socket_action(multi.get(), s, events, &stillRunning);
+}
+
+inline void SocketEngine::processEvents() {
+    constexpr int maxEvents = 256;
+    epoll_event events[maxEvents];
+    int count;
+    do {
+        count = epoll_wait(epollFd, events, maxEvents, 0);
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == timerFd) {
+                uint64_t expirations;
+                if (::read(timerFd, &expirations, sizeof(expirations)) < 0) {
+                    // spurious wakeup, the timer was re-armed meanwhile
+                }
+                timerArmed = false;
+                socketAction(CURL_SOCKET_TIMEOUT, 0);
+                continue;
+            }
+            if (fd == admitFd) {
+                uint64_t expirations;
+                if (::read(admitFd, &expirations, sizeof(expirations)) < 0) {
+                    // already consumed
+                }
+                startDeferred();
+                continue;
+            }
+            int flags = 0;
+            if (events[i].events & EPOLLIN) flags |= CURL_CSELECT_IN;
+            if (events[i].events & EPOLLOUT) flags |= CURL_CSELECT_OUT;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= CURL_CSELECT_ERR;
+            socketAction(fd, flags);
+        }
+    } while (count == maxEvents);
+
+    completeFinished();
+    if (!deferred.empty()) {
+        startDeferred(); // completions may have freed in-flight slots
+    }
+}
+
+inline void SocketEngine::wait(int timeoutMs) {
+    epoll_event ev;
+    epoll_wait(epollFd, &ev, 1, timeoutMs); // only blocks; events are consumed by processEvents()
+    processEvents();
+}
+
+inline void SocketEngine::run() {
+    while (!running.empty() || !deferred.empty()) {
+        wait(-1);
+    }
+}
+
+inline void SocketEngine::completeFinished() {
+    Request::finishOn(multi.get(), [this](CURL* handle, Response response, std::exception_ptr error) {
+        auto it = running.find(handle);
+        if (it == running.end()) return;
+        std::unique_ptr<Job> job = std::move(it->second);
+        running.erase(it);
+        try {
+            if (job->done) job->done(std::move(response), error);
+        } catch (...) {
+            // a throwing callback must not break the loop
+        }
+    });
+}
+
+inline curl_off_t downloadParallel(const std::string& url, const std::string& path,
+                                   const ParallelDownloadOptions& options) {
+    Request probe;
+    if (options.configure) options.configure(probe);
+    Response head = probe.setMethod(Request::Method::HEAD).setURL(url).send();
+
+    curl_off_t length = -1;
+    bool ranges = false;
+    std::string validator;
+    if (head.httpCode >= 200 && head.httpCode < 300) {
+        auto contentLength = head.getHeader("Content-Length");
+        if (!contentLength.empty()) {
+            length = std::strtoll(contentLength.back().c_str(), nullptr, 10);
+        }
+        for (const auto& value : head.getHeader("Accept-Ranges")) {
+            ranges = ranges || value.find("bytes") != std::string::npos;
+        }
+        validator = detail::ifRangeValidator(head);
+    }
+
+    curl_off_t partSize = std::max<curl_off_t>(options.minPartSize, 1);
+    curl_off_t parts = ranges && length > 0
+        ? std::clamp<curl_off_t>(length / partSize, 1, std::max(options.connections, 1u))
+        : 1;
+
+    if (parts == 1) {
+        Request single;
+        if (options.configure) options.configure(single);
+        if (!FilePtr(std::fopen(path.c_str(), "wb"))) {
+            throw RequestException("Failed to open file for writing: " + path);
+        }
+        try {
+            Response res = single.setURL(url).downloadToFile(path).send();
+            if (res.httpCode < 200 || res.httpCode >= 300) {
+                throw RequestException("Download of " + url + " failed with HTTP " + std::to_string(res.httpCode));
+            }
+            struct stat st{};
+            if (::stat(path.c_str(), &st) != 0 || (length >= 0 && st.st_size != length)) {
+                throw RequestException("Downloaded size of " + path + " does not match Content-Length");
+            }
+            return st.st_size;
+        } catch (...) {
+            std::remove(path.c_str()); // a partial file, or an error page
+            throw;
+        }
+    }
+
+    FilePtr file(std::fopen(path.c_str(), "wb"));
+    if (!file) {
+        throw RequestException("Failed to open file for writing: " + path);
+    }
+    // from here on a failure must not leave a preallocated, partly zero file behind
+    try {
+        int fd = fileno(file.get());
+        if (int err = posix_fallocate(fd, 0, length)) {
+            throw RequestException("Failed to allocate " + std::to_string(length) + " bytes for " + path +
+                                   ": " + std::strerror(err));
+        }
+
+        std::vector<curl_off_t> written(static_cast<size_t>(parts), 0);
+        std::vector<std::future<Response>> results;
+        EngineOptions engineOptions;
+        engineOptions.multiplex = false; // separate connections, not streams sharing one
+        Engine engine(engineOptions);    // declared after the sinks' state: stopped before it goes away
+
+        for (curl_off_t i = 0; i < parts; ++i) {
+            curl_off_t first = length * i / parts;
+            curl_off_t last = length * (i + 1) / parts - 1;
+            curl_off_t* done = &written[static_cast<size_t>(i)];
+
+            Request part;
+            if (options.configure) options.configure(part);
+            part.setURL(url).setRange(first, last).setHeaderMode(Request::HeaderMode::None);
+            if (!validator.empty()) part.addHeader("If-Range: " + validator);
+            part.setBodySink([fd, first, last, done](const char* data, size_t size) {
+                if (*done < 0 || first + *done + static_cast<curl_off_t>(size) > last + 1) {
+                    *done = -1; // more than the range: the server sent the whole (maybe changed) file
+                    return SinkAction::Abort;
+                }
+                while (size > 0) {
+                    ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(first + *done));
+                    if (n < 0) {
+                        if (errno == EINTR) continue;
+                        return SinkAction::Abort;
+                    }
+                    data += n;
+                    size -= static_cast<size_t>(n);
+                    *done += n;
+                }
+                return SinkAction::Continue;
+            });
+            results.push_back(engine.submit(std::move(part)));
+        }
+
+        std::exception_ptr failure;
+        for (curl_off_t i = 0; i < parts; ++i) {
+            try {
+                Response res = results[static_cast<size_t>(i)].get();
+                curl_off_t expected = length * (i + 1) / parts - length * i / parts;
+                if (res.httpCode != 206) {
+                    throw RequestException("Range request for " + url + " answered with HTTP " +
+                                           std::to_string(res.httpCode) + " instead of 206");
+                }
+                if (written[static_cast<size_t>(i)] != expected) {
+                    throw RequestException("Range " + std::to_string(i) + " of " + url + " is incomplete");
+                }
+            } catch (...) {
+                if (failure) continue;
+                failure = written[static_cast<size_t>(i)] < 0
+                    ? std::make_exception_ptr(RequestException("Range request for " + url +
+                          " answered with the full file: ranges unsupported, or the file changed during download"))
+                    : std::current_exception();
+            }
+        }
+        if (failure) std::rethrow_exception(failure);
+
+        if (std::fflush(file.get()) != 0) {
+            throw RequestException("Failed to write " + path);
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size != length) {
+            throw RequestException("Downloaded size of " + path + " does not match Content-Length");
+        }
+        return length;
+    } catch (...) {
+        file.reset();
+        std::remove(path.c_str());
+        throw;
+    }
+}
+#endif
+
+inline Batch::Batch(BatchOptions options) : options(options), multi(curl_multi_init()) {
+    if (!multi) {
+        throw InitializationException("Curl multi initialization failed");
+    }
+    detail::applyEngineOptions(multi.get(), options.connections);
+}
+
+inline std::vector<Batch::Result> Batch::run(std::vector<Request> requests) {
+    std::vector<Result> results(requests.size());
+    std::vector<bool> finished(requests.size(), false);
+    std::unordered_map<CURL*, std::size_t> active;
+    std::vector<std::size_t> deferred; // waiting for their rate limiter
+    std::size_t next = 0;
+    bool cancelled = false;
+    const std::size_t concurrency = std::max<std::size_t>(options.concurrency, 1);
+
+    auto fail = [&](std::size_t i, std::exception_ptr error) {
+        results[i].error = error;
+        finished[i] = true;
+        cancelled = cancelled || options.cancelOnFailure;
+    };
+    // returns false when the request has to wait for its rate limiter
+    auto start = [&](std::size_t i) {
+        Request& request = requests[i];
+        try {
+            if (!request.startOn(multi.get(), options.connections)) return false;
+            active.emplace(request.curlHandle.get(), i);
+        } catch (...) {
+            fail(i, std::current_exception());
+        }
+        return true;
+    };
+
+    while (!cancelled) {
+        std::vector<std::size_t> waiting;
+        waiting.swap(deferred);
+        for (std::size_t i : waiting) {
+            if (active.size() >= concurrency || !start(i)) deferred.push_back(i);
+        }
+        while (!cancelled && active.size() < concurrency && next < requests.size()) {
+            std::size_t i = next++;
+            if (!start(i)) deferred.push_back(i);
+        }
+        if (active.empty() && deferred.empty() && next == requests.size()) break;
+
+        int stillRunning = 0;
+        curl_multi_perform(multi.get(), &stillRunning);
+
+        Request::finishOn(multi.get(), [&](CURL* handle, Response response, std::exception_ptr error) {
+            auto it = active.find(handle);
+            if (it == active.end()) return;
+            std::size_t i = it->second;
+            active.erase(it);
+            if (error) {
+                fail(i, error);
+            } else {
+                results[i].response = std::move(response);
+                finished[i] = true;
+            }
+        });
+        if (cancelled) break;
+
+        int timeout = 1000;
+        for (std::size_t i : deferred) {
+            auto wait = requests[i].rateLimiter->admissionDelay(detail::hostKey(requests[i].url));
+            timeout = std::min(timeout, std::max(1, static_cast<int>(wait.count())));
+        }
+        if (!active.empty() || !deferred.empty()) {
+            curl_multi_poll(multi.get(), nullptr, 0, timeout, nullptr);
+        }
+    }
+
+    if (cancelled) {
+        for (auto& entry : active) {
+            curl_multi_remove_handle(multi.get(), entry.first);
+        }
+        active.clear();
+        auto cancellation = std::make_exception_ptr(
+            RequestException("Cancelled: an earlier request in the batch failed"));
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (!finished[i]) results[i].error = cancellation;
+        }
+    }
+    return results;
+}
+
 } // namespace curling
@@ -2,6 +2,8 @@
 #include "doctest.h"
 #include "webdriver.hpp"
 #include "json.hpp"
+#include "test_server.hpp"
+#include <filesystem>
 #include <string>
 
 const nlohmann::json caps = nlohmann::json::parse(R"({
@@ -523,3 +525,851 @@ TEST_CASE("Perform mouse click and drag using performActions") {
 
     client.deleteSession();
 }
+
+TEST_CASE("Commands reuse the client's connection") {
+    WebDriverClient client("http://localhost:4444");
+    client.createSession(caps);
+
+    client.navigateTo("https://example.com");
+    client.getTitle();
+    client.getCurrentUrl();
+
+    auto stats = client.connectionStats();
+    CHECK(stats.opened >= 1);
+    CHECK(stats.reused >= 2);
+
+    client.deleteSession();
+}
+
+TEST_CASE("Command timing is reported") {
+    WebDriverClient client("http://localhost:4444");
+    client.createSession(caps);
+
+    client.navigateTo("https://example.com");
+    auto timing = client.lastTransfer();
+    CHECK(timing.total.count() > 0);
+    CHECK(timing.startTransfer >= timing.preTransfer);
+    CHECK(timing.serverTime() <= timing.total);
+    CHECK(timing.bytesUploaded > 0);
+
+    client.deleteSession();
+}
+
+TEST_CASE("Commands fail fast once a dead driver opens the circuit") {
+    WebDriverClient client("http://127.0.0.1:9"); // nothing listens on the discard port
+    client.setCircuitBreaker(std::make_shared<curling::CircuitBreaker>(2, std::chrono::seconds(60)));
+
+    CHECK_THROWS(client.createSession(caps));
+    CHECK_THROWS(client.createSession(caps));
+    CHECK_THROWS_AS(client.createSession(caps), curling::CircuitOpenException);
+}
+
+TEST_CASE("Retry delays back off exponentially up to maxDelay") {
+    curling::RetryPolicy policy;
+    policy.baseDelay = std::chrono::milliseconds(100);
+    policy.maxDelay = std::chrono::milliseconds(1000);
+    policy.jitter = 0;
+
+    CHECK(policy.delayFor(1) == std::chrono::milliseconds(100));
+    CHECK(policy.delayFor(2) == std::chrono::milliseconds(200));
+    CHECK(policy.delayFor(4) == std::chrono::milliseconds(800));
+    CHECK(policy.delayFor(5) == std::chrono::milliseconds(1000));
+    CHECK(policy.delayFor(30) == std::chrono::milliseconds(1000));
+
+    policy.jitter = 0.5;
+    for (int i = 0; i < 100; ++i) {
+        auto delay = policy.delayFor(3);
+        CHECK(delay >= std::chrono::milliseconds(200));
+        CHECK(delay <= std::chrono::milliseconds(400));
+    }
+}
+
+TEST_CASE("Retry-After is a minimum delay capped at maxDelay") {
+    curling::RetryPolicy policy;
+    policy.baseDelay = std::chrono::milliseconds(100);
+    policy.maxDelay = std::chrono::milliseconds(5000);
+    policy.jitter = 0;
+
+    CHECK(policy.delayFor(1, std::chrono::seconds(2)) == std::chrono::milliseconds(2000));
+    CHECK(policy.delayFor(1, std::chrono::milliseconds(50)) == std::chrono::milliseconds(100));
+    CHECK(policy.delayFor(1, std::chrono::seconds(3600)) == std::chrono::milliseconds(5000));
+}
+
+TEST_CASE("A Retry-After beyond maxDelay ends the retries") {
+    std::atomic<int> hits{0};
+    TestServer server([&hits](const TestRequest&) {
+        ++hits;
+        TestReply reply;
+        reply.status = 503;
+        reply.headers = {{"Retry-After", "30"}};
+        return reply;
+    });
+    curling::RetryPolicy policy;
+    policy.maxDelay = std::chrono::milliseconds(1000);
+    policy.budget = nullptr;
+
+    curling::Request request;
+    request.setURL(server.url());
+    auto response = request.send(policy);
+    CHECK(response.httpCode == 503);
+    CHECK(hits == 1);
+}
+
+TEST_CASE("Responses already streamed to a sink are not retried") {
+    std::atomic<int> hits{0};
+    TestServer server([&hits](const TestRequest&) {
+        TestReply reply;
+        if (++hits == 1) {
+            reply.status = 503;
+            reply.body = "errorpage";
+        } else {
+            reply.body = "ok";
+        }
+        return reply;
+    });
+    curling::RetryPolicy policy;
+    policy.baseDelay = std::chrono::milliseconds(1);
+    policy.budget = nullptr;
+
+    std::string sunk;
+    curling::Request request;
+    request.setURL(server.url()).setBodySink([&sunk](const char* data, size_t size) {
+        sunk.append(data, size);
+        return curling::SinkAction::Continue;
+    });
+    auto response = request.send(policy);
+    CHECK(response.httpCode == 503);
+    CHECK(sunk == "errorpage");
+    CHECK(hits == 1);
+}
+
+TEST_CASE("RetryBudget runs dry and refills") {
+    curling::RetryBudget empty(3, 0);
+    CHECK(empty.tryAcquire());
+    CHECK(empty.tryAcquire());
+    CHECK(empty.tryAcquire());
+    CHECK_FALSE(empty.tryAcquire());
+
+    curling::RetryBudget refilling(1, 50);
+    CHECK(refilling.tryAcquire());
+    CHECK_FALSE(refilling.tryAcquire());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK(refilling.tryAcquire());
+}
+
+TEST_CASE("RateLimiter refills tokens at its rate") {
+    curling::RateLimiter limiter(20, 2); // one token every 50ms, two back to back
+    CHECK(limiter.tryAcquire("a:80"));
+    CHECK(limiter.tryAcquire("a:80"));
+    CHECK_FALSE(limiter.tryAcquire("a:80"));
+    CHECK(limiter.tryAcquire("b:80")); // hosts have buckets of their own
+
+    auto delay = limiter.admissionDelay("a:80");
+    CHECK(delay.count() > 0);
+    CHECK(delay <= std::chrono::milliseconds(50));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK(limiter.tryAcquire("a:80"));
+    CHECK_FALSE(limiter.tryAcquire("a:80"));
+}
+
+TEST_CASE("RateLimiter caps requests in flight") {
+    curling::RateLimiter limiter(0, 1, 2);
+    auto first = limiter.tryAcquire("a:80");
+    auto second = limiter.tryAcquire("a:80");
+    REQUIRE(first);
+    REQUIRE(second);
+    CHECK_FALSE(limiter.tryAcquire("a:80"));
+    CHECK(limiter.admissionDelay("a:80").count() > 0);
+
+    first->release();
+    CHECK(limiter.admissionDelay("a:80").count() == 0);
+    CHECK(limiter.tryAcquire("a:80"));
+}
+
+TEST_CASE("RateLimiter permits are released on scope exit") {
+    curling::RateLimiter limiter(0, 1, 1);
+    {
+        auto permit = limiter.acquire("a:80");
+        CHECK_FALSE(limiter.tryAcquire("a:80"));
+        auto moved = std::move(permit); // the slot moves with the permit
+        CHECK_FALSE(limiter.tryAcquire("a:80"));
+    }
+    CHECK(limiter.tryAcquire("a:80"));
+
+    // a blocked acquire() is woken by the release
+    auto held = std::make_unique<curling::RateLimiter::Permit>(limiter.acquire("a:80"));
+    std::atomic<bool> releasing{false};
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        releasing = true;
+        held.reset();
+    });
+    auto next = limiter.acquire("a:80");
+    CHECK(releasing);
+    releaser.join();
+}
+
+TEST_CASE("RateLimiter forgets idle hosts") {
+    curling::RateLimiter limiter(0, 1, 1);
+    auto busy = limiter.tryAcquire("busy:80");
+    REQUIRE(busy);
+    int admitted = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (limiter.tryAcquire("host" + std::to_string(i) + ":80")) ++admitted;
+    }
+    CHECK(admitted == 1000);
+    CHECK(limiter.trackedHosts() <= 64);
+    CHECK_FALSE(limiter.tryAcquire("busy:80")); // a host in flight keeps its state
+    busy->release();
+    CHECK(limiter.tryAcquire("busy:80"));
+}
+
+TEST_CASE("CircuitBreaker opens, probes and closes") {
+    using State = curling::CircuitBreaker::State;
+    curling::CircuitBreaker breaker(3, std::chrono::milliseconds(50));
+    const std::string endpoint = "driver:4444";
+
+    CHECK(breaker.state(endpoint) == State::Closed);
+    breaker.record(endpoint, false);
+    breaker.record(endpoint, true); // failures must be consecutive
+    breaker.record(endpoint, false);
+    breaker.record(endpoint, false);
+    CHECK(breaker.state(endpoint) == State::Closed);
+    CHECK(breaker.allow(endpoint));
+    breaker.record(endpoint, false);
+    CHECK(breaker.state(endpoint) == State::Open);
+    CHECK_FALSE(breaker.allow(endpoint));
+    CHECK(breaker.allow("other:4444")); // endpoints are tracked separately
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK(breaker.allow(endpoint)); // the probe
+    CHECK(breaker.state(endpoint) == State::HalfOpen);
+    CHECK_FALSE(breaker.allow(endpoint)); // only one probe at a time
+    breaker.record(endpoint, false);
+    CHECK(breaker.state(endpoint) == State::Open);
+    CHECK_FALSE(breaker.allow(endpoint));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    CHECK(breaker.allow(endpoint));
+    breaker.record(endpoint, true);
+    CHECK(breaker.state(endpoint) == State::Closed);
+    CHECK(breaker.allow(endpoint));
+}
+
+TEST_CASE("CircuitBreaker counts unreachable endpoints and 5xx gateways as failures") {
+    CHECK(curling::CircuitBreaker::isFailure(CURLE_COULDNT_CONNECT, 0));
+    CHECK(curling::CircuitBreaker::isFailure(CURLE_OPERATION_TIMEDOUT, 0));
+    CHECK(curling::CircuitBreaker::isFailure(CURLE_OK, 503));
+    CHECK_FALSE(curling::CircuitBreaker::isFailure(CURLE_OK, 200));
+    CHECK_FALSE(curling::CircuitBreaker::isFailure(CURLE_OK, 404));
+    CHECK_FALSE(curling::CircuitBreaker::isFailure(CURLE_OK, 500));
+}
+
+TEST_CASE("Bandwidth limits left at 0 take the defaults") {
+    curling::BandwidthLimits defaults;
+    defaults.maxRecvBytesPerSecond = 1000;
+    defaults.maxSendBytesPerSecond = 2000;
+    defaults.lowSpeedBytesPerSecond = 10;
+    defaults.lowSpeedTime = std::chrono::seconds(30);
+
+    auto merged = curling::BandwidthLimits{}.orDefaults(defaults);
+    CHECK(merged.maxRecvBytesPerSecond == 1000);
+    CHECK(merged.maxSendBytesPerSecond == 2000);
+    CHECK(merged.lowSpeedBytesPerSecond == 10);
+    CHECK(merged.lowSpeedTime == std::chrono::seconds(30));
+
+    curling::BandwidthLimits own;
+    own.maxRecvBytesPerSecond = 500;
+    own.lowSpeedTime = std::chrono::seconds(5); // the low-speed pair is taken as a whole
+    merged = own.orDefaults(defaults);
+    CHECK(merged.maxRecvBytesPerSecond == 500);
+    CHECK(merged.maxSendBytesPerSecond == 2000);
+    CHECK(merged.lowSpeedBytesPerSecond == 0);
+    CHECK(merged.lowSpeedTime == std::chrono::seconds(5));
+}
+
+TEST_CASE("Stalled transfers are aborted by the low-speed limit") {
+    TestServer silent(TestServer::silent());
+    curling::Request request;
+    request.setURL(silent.url()).setLowSpeedLimit(1000, std::chrono::seconds(1));
+    CHECK_THROWS_WITH_AS(request.send(), doctest::Contains(curl_easy_strerror(CURLE_OPERATION_TIMEDOUT)),
+                         curling::RequestException);
+
+    // the same limit given as an engine default
+    curling::EngineOptions options;
+    options.bandwidth.lowSpeedBytesPerSecond = 1000;
+    options.bandwidth.lowSpeedTime = std::chrono::seconds(1);
+    curling::Engine engine(options);
+    curling::Request queued;
+    queued.setURL(silent.url());
+    CHECK_THROWS_WITH_AS(engine.submit(std::move(queued)).get(),
+                         doctest::Contains(curl_easy_strerror(CURLE_OPERATION_TIMEDOUT)), curling::RequestException);
+}
+
+TEST_CASE("Raw headers are found before and after parseHeaders") {
+    curling::Response response;
+    response.rawHeaders = "HTTP/1.1 200 OK\r\nX-Value: 1\r\nx-value: 2\r\nETag: \"v1\"\r\n\r\n";
+    CHECK(response.getHeader("X-Value") == std::vector<std::string>{"1", "2"});
+    CHECK(response.getHeader("etag") == std::vector<std::string>{"\"v1\""});
+
+    response.parseHeaders();
+    response.parseHeaders();
+    CHECK(response.headers["x-value"].size() == 2);
+    CHECK(response.getHeader("x-value").size() == 2);
+}
+
+TEST_CASE("Header modes keep, defer or discard response headers") {
+    TestServer server([](const TestRequest& request) {
+        TestReply reply;
+        if (request.path == "/moved") {
+            reply.status = 302;
+            reply.headers = {{"Location", "/target"}, {"X-Value", "stale"}};
+        } else {
+            reply.headers = {{"X-Value", "1"}, {"X-Value", "2"}};
+            reply.body = "ok";
+        }
+        return reply;
+    });
+
+    curling::Request raw;
+    raw.setURL(server.url("/moved")).setFollowRedirects(true).setHeaderMode(curling::Request::HeaderMode::Raw);
+    auto response = raw.send();
+    CHECK(response.body == "ok");
+    CHECK(response.headers.empty());
+    CHECK(response.rawHeaders.rfind("HTTP/1.1 200", 0) == 0); // the redirect's headers are dropped
+    CHECK(response.getHeader("X-Value") == std::vector<std::string>{"1", "2"});
+    CHECK(response.getHeader("location").empty());
+
+    curling::Request none;
+    none.setURL(server.url("/target")).setHeaderMode(curling::Request::HeaderMode::None);
+    response = none.send();
+    CHECK(response.httpCode == 200);
+    CHECK(response.body == "ok");
+    CHECK(response.headers.empty());
+    CHECK(response.rawHeaders.empty());
+    CHECK(response.getHeader("x-value").empty());
+}
+
+TEST_CASE("A reused handle keeps its connection across reset()") {
+    TestServer server(TestServer::text("ok"));
+    curling::Request request;
+    request.setReuseHandle();
+    CHECK(request.setURL(server.url("/first")).send().body == "ok");
+    request.reset();
+    auto response = request.setURL(server.url("/second")).send();
+    CHECK(response.body == "ok");
+    CHECK(response.info.connectionReused());
+    CHECK(server.connections() == 1);
+
+    curling::Request fresh;
+    fresh.setURL(server.url()).send();
+    fresh.reset();
+    fresh.setURL(server.url()).send();
+    CHECK(server.connections() == 3); // without reuse each handle dials anew
+}
+
+TEST_CASE("A response buffer is filled in place and reused") {
+    const std::string content = testContent(100000);
+    TestServer server([&content](const TestRequest&) {
+        TestReply reply;
+        reply.body = content;
+        return reply;
+    });
+    std::string buffer = "stale";
+    buffer.reserve(256 * 1024);
+    const char* storage = buffer.data();
+
+    curling::Request request;
+    request.setReuseHandle();
+    auto response = request.setURL(server.url()).setResponseBuffer(std::move(buffer)).send();
+    CHECK(response.body == content);
+    CHECK(response.body.data() == storage);
+
+    auto again = request.setURL(server.url()).setResponseBuffer(std::move(response.body)).send();
+    CHECK(again.body == content);
+    CHECK(again.body.data() == storage);
+}
+
+TEST_CASE("Pooled handles outlive the shared cache of their last Request") {
+    TestServer server(TestServer::text("ok"));
+    auto pool = std::make_shared<curling::HandlePool>(1);
+    {
+        auto cache = std::make_shared<curling::SharedCache>();
+        curling::Request request(pool);
+        request.setURL(server.url()).setSharedCache(cache);
+        CHECK(request.send().body == "ok");
+    } // the cache dies with the Request, the handle goes back to the pool
+    CHECK(pool->idle() == 1);
+
+    curling::Request reused(pool);
+    CHECK(pool->idle() == 0);
+    reused.setURL(server.url());
+    CHECK(reused.send().body == "ok");
+}
+
+TEST_CASE("A Request needs a pool to take its handle from") {
+    CHECK_THROWS_AS(curling::Request(std::shared_ptr<curling::HandlePool>()), curling::LogicException);
+}
+
+TEST_CASE("Clients do not block on a silent driver") {
+    TestServer silent(TestServer::silent());
+    auto breaker = std::make_shared<curling::CircuitBreaker>(1, std::chrono::seconds(60));
+    WebDriverClient client(silent.url(""));
+    client.setCircuitBreaker(breaker);
+    CHECK(silent.connections() == 0); // construction does not touch the network
+
+    CHECK_FALSE(client.preconnect(std::chrono::milliseconds(200))); // returns: bounded by its timeout
+    CHECK(breaker->state(curling::RateLimiter::hostOf(silent.url())) == curling::CircuitBreaker::State::Closed);
+}
+
+TEST_CASE("Clients do not share a circuit breaker by default") {
+    WebDriverClient dead("http://127.0.0.1:9"); // nothing listens on the discard port
+    int open = 0;
+    for (int i = 0; i < 6; ++i) {
+        try {
+            dead.getStatus();
+        } catch (const curling::CircuitOpenException&) {
+            ++open;
+        } catch (const curling::RequestException&) {
+        }
+    }
+    CHECK(open == 0);
+    CHECK(curling::CircuitBreaker::process()->state("127.0.0.1:9") == curling::CircuitBreaker::State::Closed);
+}
+
+TEST_CASE("Preconnect opens the connection the first command uses") {
+    TestServer driver(TestServer::text(R"({"value": {"ready": true}})"));
+    WebDriverClient client(driver.url(""));
+    CHECK(client.preconnect());
+    client.getStatus();
+    CHECK(client.connectionStats().opened == 1);
+    CHECK(client.connectionStats().reused == 1);
+    CHECK(driver.connections() == 1);
+}
+
+TEST_CASE("Requests and clients reach a driver through a Unix socket") {
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_test.sock").string();
+    std::mutex mutex;
+    std::vector<TestRequest> received;
+    TestServer driver([&](const TestRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(request);
+        TestReply reply;
+        reply.body = R"({"value": {"ready": true}})";
+        return reply;
+    }, path);
+
+    curling::Request request;
+    auto response = request.setURL(driver.url("/plain")).setUnixSocketPath(path).send();
+    CHECK(response.httpCode == 200);
+
+    WebDriverClient client(WebDriverClient::UnixSocket{path});
+    CHECK_FALSE(client.transportProfile().tcpNoDelay);
+    CHECK_FALSE(client.transportProfile().tcpKeepAlive);
+    CHECK(client.getStatus()["ready"] == true);
+    CHECK(client.getStatus()["ready"] == true);
+    CHECK(client.connectionStats().reused == 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(received.size() == 3);
+    CHECK(received[0].path == "/plain");
+    CHECK(received[2].path == "/status");
+    CHECK(received[2].header("accept-encoding").empty()); // no compression on a local socket
+}
+
+TEST_CASE("Compressed responses are negotiated and decoded") {
+    // gzip of "compressed " repeated 20 times
+    static const char gzipped[] = "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x4b\xce\xcf\x2d\x28\x4a\x2d"
+                                  "\x2e\x4e\x4d\x51\x48\x1e\x6e\x4c\x00\xa4\x16\xfa\xe9\xdc\x00\x00\x00";
+    std::string plain;
+    for (int i = 0; i < 20; ++i) plain += "compressed ";
+    std::mutex mutex;
+    std::string offered;
+    TestServer server([&](const TestRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        offered = request.header("accept-encoding");
+        TestReply reply;
+        if (offered.find("gzip") != std::string::npos) {
+            reply.headers = {{"Content-Encoding", "gzip"}};
+            reply.body.assign(gzipped, sizeof(gzipped) - 1);
+        } else {
+            reply.body = plain;
+        }
+        return reply;
+    });
+    if (curling::Request::supportedEncodings().find("gzip") == std::string::npos) return; // libcurl without zlib
+
+    curling::Request request;
+    auto response = request.setURL(server.url()).enableCompression().send();
+    CHECK(response.body == plain);
+    CHECK(response.info.bytesDownloaded == static_cast<curl_off_t>(sizeof(gzipped) - 1));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK(offered.find("gzip") != std::string::npos);
+    }
+
+    curling::Request identity;
+    response = identity.setURL(server.url()).send();
+    CHECK(response.body == plain);
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(offered.empty());
+}
+
+TEST_CASE("Engine performs concurrent requests") {
+    TestServer server(TestServer::echoPath());
+    curling::Engine engine;
+    std::vector<std::future<curling::Response>> futures;
+    for (int i = 0; i < 8; ++i) {
+        curling::Request request;
+        request.setURL(server.url("/item/" + std::to_string(i)));
+        futures.push_back(engine.submit(std::move(request)));
+    }
+    for (int i = 0; i < 8; ++i) {
+        auto response = futures[i].get();
+        CHECK(response.httpCode == 200);
+        CHECK(response.body == "/item/" + std::to_string(i));
+    }
+}
+
+TEST_CASE("Engines with multiplexing still serve HTTP/1.1 servers") {
+    TestServer server(TestServer::echoPath());
+    for (bool multiplex : {true, false}) {
+        CAPTURE(multiplex);
+        curling::EngineOptions options;
+        options.multiplex = multiplex; // PIPEWAIT and CURLPIPE_MULTIPLEX, or neither
+        options.maxHostConnections = 2;
+        curling::Engine engine(options);
+        std::vector<std::future<curling::Response>> futures;
+        for (int i = 0; i < 8; ++i) {
+            curling::Request request;
+            request.setURL(server.url("/item/" + std::to_string(i))); // cleartext: HTTP/1.1
+            futures.push_back(engine.submit(std::move(request)));
+        }
+        for (int i = 0; i < 8; ++i) {
+            auto response = futures[i].get();
+            CHECK(response.httpCode == 200);
+            CHECK(response.body == "/item/" + std::to_string(i));
+        }
+    }
+    CHECK(server.connections() <= 4); // HTTP/1.1 keeps one transfer per connection, within the cap
+}
+
+TEST_CASE("SocketEngine performs concurrent requests") {
+    TestServer server(TestServer::echoPath());
+    curling::SocketEngine engine;
+    std::vector<std::future<curling::Response>> futures;
+    for (int i = 0; i < 8; ++i) {
+        curling::Request request;
+        request.setURL(server.url("/item/" + std::to_string(i)));
+        futures.push_back(engine.submit(std::move(request)));
+    }
+    engine.run();
+    for (int i = 0; i < 8; ++i) {
+        auto response = futures[i].get();
+        CHECK(response.httpCode == 200);
+        CHECK(response.body == "/item/" + std::to_string(i));
+    }
+}
+
+TEST_CASE("SocketEngine times out a silent server through its timer") {
+    TestServer silent(TestServer::silent());
+    curling::SocketEngine engine;
+    curling::Request request;
+    request.setURL(silent.url()).setTimeout(1);
+    auto future = engine.submit(std::move(request));
+    engine.run();
+    CHECK_THROWS_WITH_AS(future.get(), doctest::Contains(curl_easy_strerror(CURLE_OPERATION_TIMEDOUT)),
+                         curling::RequestException);
+}
+
+TEST_CASE("Batch returns results in request order") {
+    std::atomic<int> inFlight{0}, maxInFlight{0};
+    TestServer server([&](const TestRequest& request) {
+        int now = ++inFlight;
+        int seen = maxInFlight.load();
+        while (now > seen && !maxInFlight.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // lets transfers overlap; nothing is timed
+        --inFlight;
+        TestReply reply;
+        reply.body = request.path;
+        return reply;
+    });
+    auto limiter = std::make_shared<curling::RateLimiter>(0, 1, 2); // two in flight at a time
+
+    std::vector<curling::Request> requests(7);
+    for (int i = 0; i < 6; ++i) {
+        requests[i].setURL(server.url("/" + std::to_string(i))).setRateLimiter(limiter);
+    }
+    requests[6].setURL("http://127.0.0.1:9/"); // nothing listens on the discard port
+
+    auto results = curling::Batch().run(std::move(requests));
+    REQUIRE(results.size() == 7);
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(results[i].ok());
+        CHECK(results[i].response.body == "/" + std::to_string(i));
+    }
+    CHECK_FALSE(results[6].ok());
+    CHECK(maxInFlight <= 2);
+}
+
+TEST_CASE("Moved and viewed bodies arrive intact") {
+    TestServer server(TestServer::echoBody());
+    const std::string content = testContent(512 * 1024);
+
+    std::string moved = content;
+    curling::Request owner;
+    owner.setURL(server.url()).setMethod(curling::Request::Method::POST).setBody(std::move(moved));
+    CHECK(owner.send().body == content);
+
+    // the viewed memory only has to last until send() returns
+    auto response = [&] {
+        std::string scoped = content;
+        curling::Request viewer;
+        viewer.setURL(server.url()).setMethod(curling::Request::Method::PUT).setBodyView(scoped);
+        return viewer.send();
+    }();
+    CHECK(response.body == content);
+
+    // ... or, in an engine, until the transfer is reported complete
+    curling::Engine engine;
+    std::string pending = content;
+    curling::Request submitted;
+    submitted.setURL(server.url()).setMethod(curling::Request::Method::POST).setBodyView(pending);
+    auto future = engine.submit(std::move(submitted));
+    CHECK(future.get().body == content);
+}
+
+TEST_CASE("Streamed bodies arrive intact") {
+    std::mutex mutex;
+    std::vector<TestRequest> received;
+    TestServer server([&](const TestRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(request);
+        return TestReply{};
+    });
+    auto last = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received.back();
+    };
+
+    // a generator of unknown length goes out chunked
+    int pieces = 0;
+    curling::Request source;
+    source.setURL(server.url("/source")).setMethod(curling::Request::Method::POST)
+          .setBodySource([&pieces](char* buffer, size_t size) -> size_t {
+              if (pieces == 3 || size < 5) return 0;
+              std::memcpy(buffer, "piece", 5);
+              ++pieces;
+              return 5;
+          });
+    CHECK(source.send().httpCode == 200);
+    CHECK(last().method == "POST");
+    CHECK(last().header("transfer-encoding") == "chunked");
+    CHECK(last().body == "piecepiecepiece");
+
+    // a file is sent with its size as Content-Length
+    const std::string content = testContent(1024 * 1024 + 3);
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_upload.bin").string();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+    curling::Request file;
+    file.setURL(server.url("/file")).setMethod(curling::Request::Method::PUT).setBodyFile(path);
+    CHECK(file.send().httpCode == 200);
+    CHECK(last().method == "PUT");
+    CHECK(last().header("content-length") == std::to_string(content.size()));
+    CHECK(last().body == content);
+    std::remove(path.c_str());
+
+    std::istringstream in("patched");
+    curling::Request stream;
+    stream.setURL(server.url("/stream")).setMethod(curling::Request::Method::PATCH).setBodyStream(in, 7);
+    CHECK(stream.send().httpCode == 200);
+    CHECK(last().method == "PATCH");
+    CHECK(last().header("content-length") == "7");
+    CHECK(last().body == "patched");
+
+    CHECK_THROWS_AS(curling::Request().setBodyFile(path), curling::RequestException);
+}
+
+TEST_CASE("Streamed bodies are rewound for retries and redirects") {
+    std::mutex mutex;
+    std::vector<TestRequest> received;
+    TestServer server([&](const TestRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(request);
+        TestReply reply;
+        if (request.path == "/flaky" && received.size() == 1) {
+            reply.status = 503;
+        } else if (request.path == "/moved") {
+            reply.status = 307;
+            reply.headers = {{"Location", "/target"}};
+        }
+        return reply;
+    });
+    const std::string content = testContent(200000);
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_rewind.bin").string();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+    curling::RetryPolicy policy;
+    policy.baseDelay = std::chrono::milliseconds(1);
+    policy.budget = nullptr;
+
+    curling::Request retried;
+    retried.setURL(server.url("/flaky")).setMethod(curling::Request::Method::PUT).setBodyFile(path);
+    CHECK(retried.send(policy).httpCode == 200);
+
+    std::istringstream in(content);
+    curling::Request redirected;
+    redirected.setURL(server.url("/moved")).setMethod(curling::Request::Method::POST)
+              .setBodyStream(in, static_cast<curl_off_t>(content.size())).setFollowRedirects(true);
+    CHECK(redirected.send().httpCode == 200);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(received.size() == 4);
+    CHECK(received[1].path == "/flaky");
+    CHECK(received[3].path == "/target");
+    for (auto& request : received) CHECK(request.body == content);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Engines refuse a sink that pauses") {
+    TestServer server(TestServer::text(testContent(64 * 1024)));
+    auto pausing = [](const char*, size_t) { return curling::SinkAction::Pause; };
+
+    curling::Engine engine;
+    curling::Request request;
+    request.setURL(server.url()).setBodySink(pausing);
+    CHECK_THROWS_AS(engine.submit(std::move(request)).get(), curling::LogicException);
+
+    std::vector<curling::Request> batch(1);
+    batch[0].setURL(server.url()).setBodySink(pausing);
+    auto results = curling::Batch().run(std::move(batch));
+    CHECK_THROWS_AS(std::rethrow_exception(results[0].error), curling::LogicException);
+}
+
+TEST_CASE("Resumed downloads fetch only the missing tail") {
+    const std::string content = testContent(1024 * 1024);
+    std::mutex mutex;
+    std::string range;
+    TestServer server([&](const TestRequest& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        range = request.header("range");
+        return serveFile(request, content, "\"v1\"");
+    });
+    auto lastRange = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return range;
+    };
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_resume.bin").string();
+    {
+        std::ofstream partial(path, std::ios::binary | std::ios::trunc);
+        partial << content.substr(0, 300000);
+    }
+
+    curling::Request request;
+    auto response = request.setURL(server.url("/file")).downloadToFile(path).setResumeDownload().send();
+    CHECK(response.httpCode == 206);
+    CHECK(lastRange() == "bytes=300000-");
+    CHECK(readFile(path) == content);
+
+    // already complete: the server answers 416 with the size, which is success
+    curling::Request again;
+    response = again.setURL(server.url("/file")).downloadToFile(path).setResumeDownload().send();
+    CHECK(lastRange() == "bytes=1048576-");
+    CHECK(response.httpCode == 200);
+    CHECK(readFile(path) == content);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("downloadParallel fetches ranges into place") {
+    const std::string content = testContent(3 * 1024 * 1024 + 17);
+    std::atomic<int> ranged{0};
+    TestServer server([&](const TestRequest& request) {
+        if (!request.header("range").empty()) ++ranged;
+        return serveFile(request, content, "\"v1\"");
+    });
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_parallel.bin").string();
+
+    curling::ParallelDownloadOptions options;
+    options.connections = 4;
+    options.minPartSize = 512 * 1024;
+    CHECK(curling::downloadParallel(server.url("/file"), path, options) == static_cast<curl_off_t>(content.size()));
+    CHECK(ranged == 4);
+    CHECK(server.connections() >= 4);
+    CHECK(readFile(path) == content);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("downloadParallel removes the file when the server's copy changes") {
+    const std::string content = testContent(2 * 1024 * 1024);
+    TestServer server([&](const TestRequest& request) {
+        // the probe sees v1, the ranges are answered by v2: If-Range gets the full file
+        return serveFile(request, content, request.method == "HEAD" ? "\"v1\"" : "\"v2\"");
+    });
+    const std::string path = (std::filesystem::temp_directory_path() / "curling_parallel_changed.bin").string();
+
+    curling::ParallelDownloadOptions options;
+    options.minPartSize = 256 * 1024;
+    CHECK_THROWS_AS(curling::downloadParallel(server.url("/file"), path, options), curling::RequestException);
+    CHECK_FALSE(std::filesystem::exists(path));
+}
+
+TEST_CASE("Awaitable commands are declared in C++17 builds too") {
+    // the class must not change with the standard, or C++17 and C++20 objects could not be linked
+    WebDriverClient client("http://127.0.0.1:9");
+    CHECK_THROWS_WITH(client.getTitleAsync(), "Session not created");
+    CHECK_NOTHROW(client.createSessionAsync()); // nothing is sent until awaited
+}
+
+#ifdef CURLYCHUNGUS_COROUTINES
+// Fire-and-forget coroutine, enough to drive the *Async commands
+struct TestTask {
+    struct promise_type {
+        TestTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+TestTask readTitle(WebDriverClient& client, std::string& title, std::exception_ptr& error) {
+    try {
+        co_await client.createSessionAsync();
+        title = co_await client.getTitleAsync();
+        co_await client.deleteSessionAsync();
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+TEST_CASE("Commands are co_awaited on a SocketEngine") {
+    TestServer driver([](const TestRequest& request) {
+        TestReply reply;
+        if (request.method == "POST" && request.path == "/session") {
+            reply.body = R"({"value": {"sessionId": "s1", "capabilities": {}}})";
+        } else if (request.method == "GET" && request.path == "/session/s1/title") {
+            reply.body = R"({"value": "Awaited"})";
+        } else {
+            reply.body = R"({"value": null})";
+        }
+        return reply;
+    });
+    curling::SocketEngine engine;
+    WebDriverClient client(driver.url(""));
+    client.setEngine(engine);
+
+    std::string title;
+    std::exception_ptr error;
+    readTitle(client, title, error);
+    engine.run();
+
+    CHECK_FALSE(error);
+    CHECK(title == "Awaited");
+}
+#endif
@@ -0,0 +1,321 @@
+#pragma once
+// In-process HTTP/1.1 server on 127.0.0.1 (or a Unix socket) for tests that need no browser,
+// plus helpers to build the replies of the usual fixtures.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct TestRequest {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers; // lowercase names
+    std::string body;
+
+    std::string header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it != headers.end() ? it->second : std::string();
+    }
+};
+
+struct TestReply {
+    int status = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    bool hang = false; // read the request, never answer
+    std::size_t bytesPerSecond = 0; // pace the body, per connection; 0 to send at once
+    std::size_t cutAfter = 0;       // close the connection after this many body bytes; 0 to send all
+};
+
+class TestServer {
+public:
+    using Handler = std::function<TestReply(const TestRequest&)>;
+
+    explicit TestServer(Handler handler) : handler(std::move(handler)) {
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), length) != 0 ||
+            ::listen(listenFd, 64) != 0 ||
+            ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            throw std::runtime_error("test server: cannot listen on 127.0.0.1");
+        }
+        port = ntohs(addr.sin_port);
+        acceptor = std::thread(&TestServer::acceptLoop, this);
+    }
+
+    // Listens on a Unix domain socket at path instead; url() then names no port.
+    TestServer(Handler handler, std::string path) : handler(std::move(handler)), socketPath(std::move(path)) {
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("test server: socket path too long: " + socketPath);
+        }
+        std::copy(socketPath.begin(), socketPath.end(), addr.sun_path);
+        ::unlink(socketPath.c_str());
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listenFd, 64) != 0) {
+            throw std::runtime_error("test server: cannot listen on " + socketPath);
+        }
+        acceptor = std::thread(&TestServer::acceptLoop, this);
+    }
+
+    ~TestServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            for (int fd : clients) ::shutdown(fd, SHUT_RDWR);
+        }
+        stopped.notify_all();
+        ::shutdown(listenFd, SHUT_RDWR);
+        acceptor.join();
+        for (auto& worker : workers) worker.join();
+        ::close(listenFd);
+        if (!socketPath.empty()) ::unlink(socketPath.c_str());
+    }
+
+    std::string url(const std::string& path = "/") const {
+        if (!socketPath.empty()) return "http://localhost" + path;
+        return "http://127.0.0.1:" + std::to_string(port) + path;
+    }
+
+    int connections() const { return accepted.load(); }
+
+    // Whether "Expect: 100-continue" is answered; many servers ignore it, and
+    // libcurl then waits a second before sending the body anyway.
+    void setAnswerContinue(bool answer) { answerContinue = answer; }
+
+    // Reads requests and never answers them, until the server stops.
+    static Handler silent() {
+        return [](const TestRequest&) {
+            TestReply reply;
+            reply.hang = true;
+            return reply;
+        };
+    }
+
+    // Answers every request with the same body.
+    static Handler text(std::string body, int status = 200) {
+        return [body = std::move(body), status](const TestRequest&) {
+            TestReply reply;
+            reply.status = status;
+            reply.body = body;
+            return reply;
+        };
+    }
+
+    // Answers every request with its own path.
+    static Handler echoPath() {
+        return [](const TestRequest& request) {
+            TestReply reply;
+            reply.body = request.path;
+            return reply;
+        };
+    }
+
+    // Answers every request with its own body.
+    static Handler echoBody() {
+        return [](const TestRequest& request) {
+            TestReply reply;
+            reply.body = request.body;
+            return reply;
+        };
+    }
+
+private:
+    Handler handler;
+    std::string socketPath;
+    int listenFd = -1;
+    int port = 0;
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool stopping = false;
+    std::vector<int> clients;
+    std::vector<std::thread> workers;
+    std::atomic<int> accepted{0};
+    std::atomic<bool> answerContinue{true};
+    std::thread acceptor;
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) return; // shut down
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                ::close(fd);
+                return;
+            }
+            ++accepted;
+            clients.push_back(fd);
+            workers.emplace_back(&TestServer::serve, this, fd);
+        }
+    }
+
+    void serve(int fd) {
+        int one = 1;
+        if (socketPath.empty()) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        std::string buffer;
+        TestRequest request;
+        while (readRequest(fd, buffer, request)) {
+            TestReply reply = handler(request);
+            if (reply.hang) {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopped.wait(lock, [this] { return stopping; });
+                break;
+            }
+            std::string out = "HTTP/1.1 " + std::to_string(reply.status) + " Test\r\n";
+            for (auto& h : reply.headers) out += h.first + ": " + h.second + "\r\n";
+            out += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n\r\n";
+            if (!writeAll(fd, out)) break;
+            if (request.method != "HEAD" && !writeBody(fd, reply)) break;
+        }
+        ::close(fd);
+    }
+
+    bool readRequest(int fd, std::string& buffer, TestRequest& request) {
+        size_t end;
+        while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!readMore(fd, buffer)) return false;
+        }
+        request = TestRequest{};
+        std::istringstream head(buffer.substr(0, end));
+        std::string line;
+        std::getline(head, line);
+        std::istringstream(line) >> request.method >> request.path;
+        while (std::getline(head, line)) {
+            auto colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            std::string value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            if (!value.empty() && value.back() == '\r') value.pop_back();
+            request.headers[name] = value;
+        }
+        buffer.erase(0, end + 4);
+        if (request.header("expect") == "100-continue" && answerContinue &&
+            !writeAll(fd, "HTTP/1.1 100 Continue\r\n\r\n")) {
+            return false;
+        }
+        if (request.header("transfer-encoding") == "chunked") {
+            return readChunked(fd, buffer, request.body);
+        }
+        std::string length = request.header("content-length");
+        size_t bodySize = length.empty() ? 0 : std::stoul(length);
+        while (buffer.size() < bodySize) {
+            if (!readMore(fd, buffer)) return false;
+        }
+        request.body = buffer.substr(0, bodySize);
+        buffer.erase(0, bodySize);
+        return true;
+    }
+
+    // Decodes a chunked body; trailers are not supported
+    static bool readChunked(int fd, std::string& buffer, std::string& body) {
+        for (;;) {
+            size_t lineEnd;
+            while ((lineEnd = buffer.find("\r\n")) == std::string::npos) {
+                if (!readMore(fd, buffer)) return false;
+            }
+            size_t size = std::stoul(buffer.substr(0, lineEnd), nullptr, 16);
+            buffer.erase(0, lineEnd + 2);
+            while (buffer.size() < size + 2) {
+                if (!readMore(fd, buffer)) return false;
+            }
+            body.append(buffer, 0, size);
+            buffer.erase(0, size + 2);
+            if (size == 0) return true;
+        }
+    }
+
+    static bool readMore(int fd, std::string& buffer) {
+        char chunk[16384];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    // False when the connection must close: write failed, or the reply is cut short
+    static bool writeBody(int fd, const TestReply& reply) {
+        std::string_view body = reply.body;
+        if (reply.cutAfter > 0) body = body.substr(0, reply.cutAfter);
+        if (reply.bytesPerSecond == 0) return writeAll(fd, body) && body.size() == reply.body.size();
+        const std::size_t slice = std::max<std::size_t>(reply.bytesPerSecond / 100, 1); // 10ms of data
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t sent = 0; sent < body.size(); sent += slice) {
+            auto due = start + std::chrono::duration<double>(static_cast<double>(sent) / reply.bytesPerSecond);
+            std::this_thread::sleep_until(std::chrono::time_point_cast<std::chrono::steady_clock::duration>(due));
+            if (!writeAll(fd, body.substr(sent, slice))) return false;
+        }
+        return body.size() == reply.body.size();
+    }
+
+    static bool writeAll(int fd, std::string_view data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+// Deterministic file contents, so misplaced ranges show up as mismatches
+inline std::string testContent(size_t size) {
+    std::string content(size, '\0');
+    for (size_t i = 0; i < size; ++i) content[i] = static_cast<char>((i * 7 + i / 251) & 0xff);
+    return content;
+}
+
+// Serves content like a static file server: byte ranges, ETag and If-Range
+inline TestReply serveFile(const TestRequest& request, const std::string& content, const std::string& etag) {
+    TestReply reply;
+    reply.headers = {{"Accept-Ranges", "bytes"}, {"ETag", etag}};
+    std::string range = request.header("range");
+    std::string ifRange = request.header("if-range");
+    if (range.rfind("bytes=", 0) != 0 || (!ifRange.empty() && ifRange != etag)) {
+        reply.body = content;
+        return reply;
+    }
+    size_t dash = range.find('-');
+    size_t first = std::stoul(range.substr(6, dash - 6));
+    size_t last = dash + 1 < range.size() ? std::stoul(range.substr(dash + 1)) : content.size() - 1;
+    if (first >= content.size()) {
+        reply.status = 416;
+        reply.headers.push_back({"Content-Range", "bytes */" + std::to_string(content.size())});
+        return reply;
+    }
+    last = std::min(last, content.size() - 1);
+    reply.status = 206;
+    reply.headers.push_back({"Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) +
+                                              "/" + std::to_string(content.size())});
+    reply.body = content.substr(first, last - first + 1);
+    return reply;
+}
+
+inline std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
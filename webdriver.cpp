@@ -5,6 +5,57 @@
 
 using json = nlohmann::json;
 
+namespace {
+// True for drivers on this machine: localhost, 127.x.x.x or [::1].
+bool isLoopbackUrl(const std::string& url) {
+    auto start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    auto end = url.find_first_of("/?#", start);
+    std::string authority = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    auto at = authority.rfind('@');
+    if (at != std::string::npos) authority.erase(0, at + 1);
+    std::string host = authority[0] == '[' ? authority.substr(0, authority.find(']') + 1)
+                                           : authority.substr(0, authority.find(':'));
+    return host == "localhost" || host == "[::1]" || host.rfind("127.", 0) == 0;
+}
+}
+
+WebDriverClient::WebDriverClient(std::string remoteUrl, std::shared_ptr<curling::SharedCache> cache)
+  : baseUrl(std::move(remoteUrl)),
+    transport(cache ? std::move(cache) : std::make_shared<curling::SharedCache>()),
+    compress(!isLoopbackUrl(baseUrl)) {
+    if (isLoopbackUrl(baseUrl)) {
+        profile = curling::TransportProfile::lowLatency();
+    }
+}
+
+WebDriverClient::WebDriverClient(UnixSocket socket, std::shared_ptr<curling::SharedCache> cache)
+  : baseUrl("http://localhost"),
+    socketPath(std::move(socket.path)),
+    transport(cache ? std::move(cache) : std::make_shared<curling::SharedCache>()),
+    profile(curling::TransportProfile::lowLatency()) {
+    // no TCP under a Unix socket: Nagle and keepalive probes do not apply
+    profile.tcpNoDelay = false;
+    profile.tcpKeepAlive = false;
+}
+
+// A warm-up, not a command: a driver that is not up yet must neither stall the
+// caller nor count against the limiter's quota or the breaker's failures.
+bool WebDriverClient::preconnect(std::chrono::milliseconds timeout) {
+    auto req = makeRequest("GET", "/status", std::nullopt);
+    req.setRateLimiter(nullptr)
+       .setCircuitBreaker(nullptr)
+       .setRawOption(CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()))
+       .setRawOption(CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+    try {
+        auto res = req.send();
+        if (!res.info.connectionReused()) ++stats.opened;
+        return true;
+    } catch (const curling::RequestException&) {
+        return false;
+    }
+}
+
 void WebDriverClient::sendKeysSlowly(const std::string& eid, const std::string& text, unsigned baseDelayMs) {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -20,6 +71,11 @@ void WebDriverClient::sendKeysSlowly(const std::string& eid, const std::string&
 }
 
 json WebDriverClient::request(const std::string& method, const std::string& path, const std::optional<json>& payload) {
+    auto req = makeRequest(method, path, payload);
+    return handleResponse(retryPolicy ? req.send(*retryPolicy) : req.send(), method, path);
+}
+
+curling::Request WebDriverClient::makeRequest(const std::string& method, const std::string& path, const std::optional<json>& payload) {
     curling::Request req;
     req.setMethod([&] {
         if (method == "GET") return curling::Request::Method::GET;
@@ -28,13 +84,30 @@ json WebDriverClient::request(const std::string& method, const std::string& path
         throw std::logic_error("Unsupported HTTP method");
     }())
     .setURL(baseUrl + path)
-    .addHeader("Content-Type: application/json");
-
+    .addHeader("Content-Type: application/json")
+    .setSharedCache(transport)
+    .setHeaderMode(curling::Request::HeaderMode::None)
+    .setTransportProfile(profile)
+    .setRateLimiter(limiter)
+    .setCircuitBreaker(breaker);
+
+    if (!socketPath.empty()) {
+        req.setUnixSocketPath(socketPath);
+    }
+    if (compress) {
+        req.enableCompression();
+    }
     if (payload) {
         req.setBody(payload->dump());
     }
+    return req;
+}
+
+json WebDriverClient::handleResponse(const curling::Response& res, const std::string& method, const std::string& path) {
+    last = res.info;
+    if (res.info.connectionReused()) ++stats.reused;
+    else ++stats.opened;
 
-    auto res = req.send();
     if (res.httpCode < 200 || res.httpCode >= 300) {
         throw std::runtime_error(
             "HTTP " + std::to_string(res.httpCode) + " error on " + method + " " + path + ": " + res.body
@@ -6,6 +6,12 @@
 #include "json.hpp"
 #include "curling.hpp"
 
+// co_await on the *Async commands needs C++20; the class is declared the same either way.
+#if defined(__linux__) && defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define CURLYCHUNGUS_COROUTINES 1
+#endif
+
 namespace detail{
 // Function to map a Base64 character to its 6-bit integer value.
 inline int base64Value(char c) {
@@ -66,8 +72,21 @@ inline void base64ToFile(const std::string &b64, const std::string &filePath) {
 
 class WebDriverClient {
 public:
-    explicit WebDriverClient(std::string remoteUrl)
-      : baseUrl(std::move(remoteUrl)) {}
+    // Connection usage of the client's transport since construction.
+    struct ConnectionStats {
+        std::size_t opened = 0; // commands that had to open a new connection
+        std::size_t reused = 0; // commands served over an already open connection
+    };
+
+    // Commands go through a connection cache owned by the client, or through
+    // `cache` when given, which may be shared with other clients and threads.
+    explicit WebDriverClient(std::string remoteUrl, std::shared_ptr<curling::SharedCache> cache = nullptr);
+
+    // Local driver reached through a Unix domain socket rather than loopback TCP.
+    struct UnixSocket {
+        std::string path;
+    };
+    explicit WebDriverClient(UnixSocket socket, std::shared_ptr<curling::SharedCache> cache = nullptr);
 
     // Session management
     std::string createSession(const nlohmann::json& caps = {{"capabilities", {{"alwaysMatch", {{"browserName", "firefox"}}}}}});
@@ -140,9 +159,196 @@ public:
     void performActions(const nlohmann::json& actions);
     void setFile(const std::string& elementId, const std::vector<std::string>& filePaths);
 
+    ConnectionStats connectionStats() const { return stats; }
+
+    // Open the connection ahead of the first command, e.g. while a test fixture is
+    // still being set up. Sends GET /status bounded by timeout, outside the rate
+    // limiter and circuit breaker. Returns false if the driver did not answer.
+    bool preconnect(std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+
+    // Timing of the most recent command: network phases up to preTransfer,
+    // driver and browser time in serverTime().
+    curling::TransferInfo lastTransfer() const { return last; }
+
+    // Ask the driver for compressed responses. On by default for remote hubs,
+    // off for loopback and Unix socket drivers where it only costs CPU.
+    void setCompression(bool enabled) { compress = enabled; }
+
+    // Retry transient failures of blocking commands (async commands are never retried).
+    // By default commands are tried once.
+    void setRetryPolicy(curling::RetryPolicy policy) { retryPolicy = std::move(policy); }
+
+    // Socket tuning of the client's requests. Loopback drivers get
+    // TransportProfile::lowLatency(), Unix socket drivers the same without its TCP
+    // options; remote hubs get libcurl's defaults.
+    void setTransportProfile(const curling::TransportProfile& profile) { this->profile = profile; }
+    const curling::TransportProfile& transportProfile() const { return profile; }
+
+    // Admit commands through a rate limiter, e.g. one shared by every client
+    // talking to the same grid, to stay under its quotas.
+    void setRateLimiter(std::shared_ptr<curling::RateLimiter> limiter) { this->limiter = std::move(limiter); }
+
+    // Fail commands fast with curling::CircuitOpenException while the driver keeps
+    // failing. Off by default; give each client a breaker of its own, or
+    // curling::CircuitBreaker::process() to share one across clients.
+    void setCircuitBreaker(std::shared_ptr<curling::CircuitBreaker> breaker) { this->breaker = std::move(breaker); }
+
+#ifdef __linux__
+    // Engine carrying the *Async commands. Completions resume the awaiting
+    // coroutine from engine.processEvents()/run(), on the thread driving it.
+    void setEngine(curling::SocketEngine& engine) { this->engine = &engine; }
+
+    // Awaitable command: suspends the coroutine while the request is in flight.
+    // Usable with co_await from C++20. Declared whatever the standard, so C++17 and
+    // C++20 translation units see the same class and can be linked together.
+    template <typename T>
+    class Command {
+    public:
+        using Convert = std::function<T(nlohmann::json)>;
+
+        Command(WebDriverClient& client, std::string method, std::string path,
+                std::optional<nlohmann::json> payload, Convert convert)
+          : client(client), method(std::move(method)), path(std::move(path)),
+            payload(std::move(payload)), convert(std::move(convert)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Handle> // std::coroutine_handle<>, named without <coroutine>
+        void await_suspend(Handle awaiting) {
+            if (!client.engine) throw std::logic_error("No engine set for async commands");
+            client.engine->submit(client.makeRequest(method, path, payload),
+                [this, awaiting](curling::Response res, std::exception_ptr err) {
+                    if (err) error = err;
+                    else {
+                        try { result = client.handleResponse(res, method, path); }
+                        catch (...) { error = std::current_exception(); }
+                    }
+                    awaiting.resume();
+                });
+        }
+
+        T await_resume() {
+            if (error) std::rethrow_exception(error);
+            return convert(std::move(result));
+        }
+
+    private:
+        WebDriverClient& client;
+        std::string method, path;
+        std::optional<nlohmann::json> payload;
+        Convert convert;
+        nlohmann::json result;
+        std::exception_ptr error;
+    };
+
+    // Overloaded rather than defaulted: GCC 12 rejects braced default arguments in co_await expressions.
+    Command<std::string> createSessionAsync();
+    Command<std::string> createSessionAsync(const nlohmann::json& caps);
+    Command<void> deleteSessionAsync();
+    Command<void> navigateToAsync(const std::string& url);
+    Command<std::string> getCurrentUrlAsync();
+    Command<std::string> getTitleAsync();
+    Command<std::string> findElementAsync(const std::string& using_, const std::string& value);
+    Command<std::vector<std::string>> findElementsAsync(const std::string& using_, const std::string& value);
+    Command<std::string> getElementTextAsync(const std::string& eid);
+    Command<void> clickElementAsync(const std::string& eid);
+    Command<void> sendKeysAsync(const std::string& eid, const std::string& text);
+    Command<nlohmann::json> executeScriptAsync(const std::string& script, const nlohmann::json& args = nlohmann::json::array());
+    Command<std::string> takeScreenshotAsync();
+#endif
+
 private:
     const std::string baseUrl;
+    const std::string socketPath; // empty for TCP
     std::string sid; //session id
+    std::shared_ptr<curling::SharedCache> transport; // connection/DNS/TLS caches kept alive across commands
+    ConnectionStats stats;
+    curling::TransferInfo last;
+    bool compress = false;
+    curling::TransportProfile profile;
+    std::shared_ptr<curling::RateLimiter> limiter;
+    std::shared_ptr<curling::CircuitBreaker> breaker;
+    std::optional<curling::RetryPolicy> retryPolicy;
+#ifdef __linux__
+    curling::SocketEngine* engine = nullptr;
+#endif
 
     nlohmann::json request(const std::string& method, const std::string& path, const std::optional<nlohmann::json>& payload = std::nullopt);
+    curling::Request makeRequest(const std::string& method, const std::string& path, const std::optional<nlohmann::json>& payload);
+    nlohmann::json handleResponse(const curling::Response& res, const std::string& method, const std::string& path);
+    const std::string& session() const;
 };
+
+inline const std::string& WebDriverClient::session() const {
+    if (sid.empty()) throw std::runtime_error("Session not created");
+    return sid;
+}
+
+#ifdef __linux__
+inline WebDriverClient::Command<std::string> WebDriverClient::createSessionAsync(const nlohmann::json& caps) {
+    return {*this, "POST", "/session", caps, [this](nlohmann::json v) {
+        sid = v.value("sessionId", v.value("session_id", ""));
+        return sid;
+    }};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::createSessionAsync() {
+    return createSessionAsync({{"capabilities", {{"alwaysMatch", {{"browserName", "firefox"}}}}}});
+}
+
+inline WebDriverClient::Command<void> WebDriverClient::deleteSessionAsync() {
+    return {*this, "DELETE", "/session/" + session(), std::nullopt, [this](nlohmann::json) { sid.clear(); }};
+}
+
+inline WebDriverClient::Command<void> WebDriverClient::navigateToAsync(const std::string& url) {
+    return {*this, "POST", "/session/" + session() + "/url", nlohmann::json{{"url", url}}, [](nlohmann::json) {}};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::getCurrentUrlAsync() {
+    return {*this, "GET", "/session/" + session() + "/url", std::nullopt,
+            [](nlohmann::json v) { return v.get<std::string>(); }};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::getTitleAsync() {
+    return {*this, "GET", "/session/" + session() + "/title", std::nullopt,
+            [](nlohmann::json v) { return v.get<std::string>(); }};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::findElementAsync(const std::string& using_, const std::string& value) {
+    return {*this, "POST", "/session/" + session() + "/element", nlohmann::json{{"using", using_}, {"value", value}},
+            [](nlohmann::json v) { return v.at("element-6066-11e4-a52e-4f735466cecf").get<std::string>(); }};
+}
+
+inline WebDriverClient::Command<std::vector<std::string>> WebDriverClient::findElementsAsync(const std::string& using_, const std::string& value) {
+    return {*this, "POST", "/session/" + session() + "/elements", nlohmann::json{{"using", using_}, {"value", value}},
+            [](nlohmann::json arr) {
+                std::vector<std::string> out;
+                for (auto& e : arr) out.push_back(e.at("element-6066-11e4-a52e-4f735466cecf").get<std::string>());
+                return out;
+            }};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::getElementTextAsync(const std::string& eid) {
+    return {*this, "GET", "/session/" + session() + "/element/" + eid + "/text", std::nullopt,
+            [](nlohmann::json v) { return v.get<std::string>(); }};
+}
+
+inline WebDriverClient::Command<void> WebDriverClient::clickElementAsync(const std::string& eid) {
+    return {*this, "POST", "/session/" + session() + "/element/" + eid + "/click", nlohmann::json::object(), [](nlohmann::json) {}};
+}
+
+inline WebDriverClient::Command<void> WebDriverClient::sendKeysAsync(const std::string& eid, const std::string& text) {
+    return {*this, "POST", "/session/" + session() + "/element/" + eid + "/value",
+            nlohmann::json{{"text", text}, {"value", std::vector<char>(text.begin(), text.end())}}, [](nlohmann::json) {}};
+}
+
+inline WebDriverClient::Command<nlohmann::json> WebDriverClient::executeScriptAsync(const std::string& script, const nlohmann::json& args) {
+    return {*this, "POST", "/session/" + session() + "/execute/sync", nlohmann::json{{"script", script}, {"args", args}},
+            [](nlohmann::json v) { return v; }};
+}
+
+inline WebDriverClient::Command<std::string> WebDriverClient::takeScreenshotAsync() {
+    return {*this, "GET", "/session/" + session() + "/screenshot", std::nullopt,
+            [](nlohmann::json v) { return v.get<std::string>(); }};
+}
+#endif